@@ -0,0 +1,351 @@
+#include "./PerfCounters.h"
+#include "./../Core/utils.h"
+#include "./../Core/Subsystems/ECS/ECSManager.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+// Micro-benchmarks of the ECS operations, reporting the time and the hardware
+// counters per operation of the best of a few repetitions
+// Usage: cowboy-bench [name filter]
+
+namespace
+{
+
+// Plain components, independent from the engine's math types
+struct Position
+{
+    float x, y, z;
+};
+
+struct Velocity
+{
+    float x, y, z;
+};
+
+struct Health
+{
+    int32_t value;
+};
+
+class MovementSystem : public System {};
+
+const std::array<uint64_t, 3> ENTITY_COUNTS = { 1000, 32768, 1 << 20 };
+const uint32_t REPETITIONS = 5;
+const uint32_t RANDOM_SEED = 42;
+
+template<typename T>
+void doNotOptimize(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Registry, its entities and the iteration order of the random accesses
+struct Fixture
+{
+    ECSManager                      ecs;
+    std::vector<Entity>             entities;
+    std::vector<Entity>             shuffled;
+    std::shared_ptr<MovementSystem> movement;
+};
+
+enum FixtureContent
+{
+    Empty,          // Registered components and systems only
+    Entities,       // Entities without components
+    Moving,         // Entities with a Position and a Velocity
+    MovingViewed    // Same with the matching of the movement view cached
+};
+
+std::unique_ptr<Fixture> makeFixture(uint64_t count, FixtureContent content)
+{
+    auto fixture = std::make_unique<Fixture>();
+    ECSManager& ecs = fixture->ecs;
+
+    ecs.registerComponent<Position>();
+    ecs.registerComponent<Velocity>();
+    ecs.registerComponent<Health>();
+    fixture->movement = ecs.registerSystem<MovementSystem>();
+    ecs.setSystemSignature<MovementSystem, Position, Velocity>();
+
+    if (content == Empty)
+    {
+        return fixture;
+    }
+
+    fixture->entities = ecs.createEntities(count);
+    if (content == Moving || content == MovingViewed)
+    {
+        std::vector<Position> positions(count);
+        std::vector<Velocity> velocities(count);
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            positions[i]  = { static_cast<float>(i), 0.0f, 0.0f };
+            velocities[i] = { 1.0f, 2.0f, 3.0f };
+        }
+        ecs.addComponents<Position, Velocity>(fixture->entities, positions, velocities);
+    }
+    if (content == MovingViewed)
+    {
+        ecs.view<Position, const Velocity>();
+    }
+
+    fixture->shuffled = fixture->entities;
+    std::shuffle(fixture->shuffled.begin(), fixture->shuffled.end(), std::mt19937(RANDOM_SEED));
+
+    return fixture;
+}
+
+class Bench
+{
+ public:
+    explicit Bench(const char* filter) : _filter(filter)
+    {
+        if (!_counters.available())
+        {
+            WARNING("Hardware counters unavailable (check kernel.perf_event_paranoid), reporting time only.");
+        }
+        std::printf("%-36s %10s %10s %10s %12s %12s\n", "benchmark", "entities", "ns/op", "instr/op", "LLC-miss/op", "L1D-miss/op");
+    }
+
+    // Times body(fixture) on a fresh fixture per repetition, body returns
+    // its number of operations
+    // The counters only cover the calling thread
+    template<typename Body>
+    void measure(const char* name, uint64_t count, FixtureContent content, Body&& body)
+    {
+        if (_filter && !std::strstr(name, _filter))
+        {
+            return;
+        }
+
+        double bestNs = 0.0;
+        uint64_t operations = 1;
+        PerfCounters::Values bestValues {};
+        for (uint32_t repetition = 0; repetition < REPETITIONS; ++repetition)
+        {
+            auto fixture = makeFixture(count, content);
+
+            _counters.start();
+            const auto start = std::chrono::steady_clock::now();
+            operations = body(*fixture);
+            const auto end = std::chrono::steady_clock::now();
+            const PerfCounters::Values values = _counters.stop();
+
+            const double ns = std::chrono::duration<double, std::nano>(end - start).count();
+            if (repetition == 0 || ns < bestNs)
+            {
+                bestNs = ns;
+                bestValues = values;
+            }
+        }
+
+        std::printf("%-36s %10lu %10.2f %10s %12s %12s\n", name, count, bestNs / operations,
+                    perOperation(bestValues, PerfCounters::Instructions, operations).data(),
+                    perOperation(bestValues, PerfCounters::CacheMisses, operations).data(),
+                    perOperation(bestValues, PerfCounters::L1DReadMisses, operations).data());
+    }
+
+ private:
+    std::array<char, 32> perOperation(const PerfCounters::Values& values, PerfCounters::Counter counter, uint64_t operations) const
+    {
+        std::array<char, 32> text {};
+        if (_counters.available(counter))
+        {
+            std::snprintf(text.data(), text.size(), "%.3f", static_cast<double>(values[counter]) / operations);
+        }
+        else
+        {
+            std::snprintf(text.data(), text.size(), "-");
+        }
+        return text;
+    }
+
+    const char*     _filter;
+    PerfCounters    _counters;
+};
+
+void run(Bench& bench, uint64_t count)
+{
+    // Entities lifetime
+
+    bench.measure("createEntity", count, Empty, [count](Fixture& fixture)
+    {
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            doNotOptimize(fixture.ecs.createEntity());
+        }
+        return count;
+    });
+
+    bench.measure("createEntities (batch)", count, Empty, [count](Fixture& fixture)
+    {
+        doNotOptimize(fixture.ecs.createEntities(count).data());
+        return count;
+    });
+
+    bench.measure("destroyEntity", count, Entities, [](Fixture& fixture)
+    {
+        for (const auto entity : fixture.entities)
+        {
+            fixture.ecs.destroyEntity(entity);
+        }
+        return fixture.entities.size();
+    });
+
+    bench.measure("destroyEntity (with components)", count, Moving, [](Fixture& fixture)
+    {
+        for (const auto entity : fixture.entities)
+        {
+            fixture.ecs.destroyEntity(entity);
+        }
+        return fixture.entities.size();
+    });
+
+    // Components insertion and removal
+
+    bench.measure("addComponent", count, Entities, [](Fixture& fixture)
+    {
+        for (const auto entity : fixture.entities)
+        {
+            fixture.ecs.addComponent<Health>(entity, { 100 });
+        }
+        return fixture.entities.size();
+    });
+
+    bench.measure("addComponents (batch)", count, Entities, [](Fixture& fixture)
+    {
+        const std::vector<Health> healths(fixture.entities.size(), { 100 });
+        fixture.ecs.addComponents<Health>(fixture.entities, healths);
+        return fixture.entities.size();
+    });
+
+    bench.measure("removeComponent", count, Moving, [](Fixture& fixture)
+    {
+        for (const auto entity : fixture.entities)
+        {
+            fixture.ecs.removeComponent<Velocity>(entity);
+        }
+        return fixture.entities.size();
+    });
+
+    // Signature changes, keeping or changing the systems of the entity
+
+    bench.measure("signature change (same systems)", count, Moving, [](Fixture& fixture)
+    {
+        for (const auto entity : fixture.entities)
+        {
+            fixture.ecs.addComponent<Health>(entity, { 100 });
+            fixture.ecs.removeComponent<Health>(entity);
+        }
+        return 2 * fixture.entities.size();
+    });
+
+    bench.measure("signature change (leave/join system)", count, Moving, [](Fixture& fixture)
+    {
+        for (const auto entity : fixture.entities)
+        {
+            fixture.ecs.removeComponent<Velocity>(entity);
+            fixture.ecs.addComponent<Velocity>(entity, { 1.0f, 2.0f, 3.0f });
+        }
+        return 2 * fixture.entities.size();
+    });
+
+    // Component access
+
+    bench.measure("getComponent (sequential)", count, Moving, [](Fixture& fixture)
+    {
+        const ECSManager& ecs = fixture.ecs;
+        float sum = 0.0f;
+        for (const auto entity : fixture.entities)
+        {
+            sum += ecs.getComponent<Position>(entity).x;
+        }
+        doNotOptimize(sum);
+        return fixture.entities.size();
+    });
+
+    bench.measure("getComponent (random)", count, Moving, [](Fixture& fixture)
+    {
+        const ECSManager& ecs = fixture.ecs;
+        float sum = 0.0f;
+        for (const auto entity : fixture.shuffled)
+        {
+            sum += ecs.getComponent<Position>(entity).x;
+        }
+        doNotOptimize(sum);
+        return fixture.shuffled.size();
+    });
+
+    bench.measure("getComponent mutable (random)", count, Moving, [](Fixture& fixture)
+    {
+        for (const auto entity : fixture.shuffled)
+        {
+            fixture.ecs.getComponent<Position>(entity).x += 1.0f;
+        }
+        return fixture.shuffled.size();
+    });
+
+    // Iteration of the moving entities
+
+    bench.measure("system iteration", count, Moving, [](Fixture& fixture)
+    {
+        ECSManager& ecs = fixture.ecs;
+        for (const auto entity : fixture.movement->_entities)
+        {
+            Position& position = ecs.getComponent<Position>(entity);
+            const Velocity& velocity = std::as_const(ecs).getComponent<Velocity>(entity);
+            position.x += velocity.x;
+            position.y += velocity.y;
+            position.z += velocity.z;
+        }
+        return fixture.movement->_entities.size();
+    });
+
+    auto move = [](Position& position, const Velocity& velocity)
+    {
+        position.x += velocity.x;
+        position.y += velocity.y;
+        position.z += velocity.z;
+    };
+
+    bench.measure("view each (cold cache)", count, Moving, [&move](Fixture& fixture)
+    {
+        auto view = fixture.ecs.view<Position, const Velocity>();
+        view.each(move);
+        return view.size();
+    });
+
+    bench.measure("view each", count, MovingViewed, [&move](Fixture& fixture)
+    {
+        auto view = fixture.ecs.view<Position, const Velocity>();
+        view.each(move);
+        return view.size();
+    });
+
+    bench.measure("view par_each", count, MovingViewed, [&move](Fixture& fixture)
+    {
+        auto view = fixture.ecs.view<Position, const Velocity>();
+        view.par_each(move);
+        return view.size();
+    });
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    Bench bench(argc > 1 ? argv[1] : nullptr);
+    for (const auto count : ENTITY_COUNTS)
+    {
+        run(bench, count);
+    }
+    return 0;
+}
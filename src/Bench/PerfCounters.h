@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Hardware counters of the calling thread read through perf_event_open
+// The counters are optional: without kernel support or permission
+// (kernel.perf_event_paranoid) every value reads as zero and available() is false
+class PerfCounters
+{
+ public:
+    enum Counter
+    {
+        Instructions,
+        CacheReferences,
+        CacheMisses,        // Last level cache
+        L1DReadMisses,
+        COUNTER_COUNT
+    };
+
+    using Values = std::array<uint64_t, COUNTER_COUNT>;
+
+    PerfCounters()
+    {
+        const uint64_t l1dReadMiss = PERF_COUNT_HW_CACHE_L1D
+                                   | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                                   | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+        _fds.fill(-1);
+        _fds[Instructions]      = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        _fds[CacheReferences]   = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES);
+        _fds[CacheMisses]       = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        _fds[L1DReadMisses]     = open(PERF_TYPE_HW_CACHE, l1dReadMiss);
+    }
+
+    ~PerfCounters()
+    {
+        for (const int fd : _fds)
+        {
+            if (fd != -1)
+            {
+                close(fd);
+            }
+        }
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // At least one counter could be opened
+    bool available() const
+    {
+        for (const int fd : _fds)
+        {
+            if (fd != -1)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool available(Counter counter) const
+    {
+        return _fds[counter] != -1;
+    }
+
+    void start()
+    {
+        for (const int fd : _fds)
+        {
+            if (fd != -1)
+            {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+    }
+
+    // Values counted since start()
+    Values stop()
+    {
+        Values values {};
+        for (uint64_t i = 0; i < COUNTER_COUNT; ++i)
+        {
+            if (_fds[i] == -1)
+            {
+                continue;
+            }
+            ioctl(_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+            uint64_t value = 0;
+            if (read(_fds[i], &value, sizeof(value)) == sizeof(value))
+            {
+                values[i] = value;
+            }
+        }
+        return values;
+    }
+
+ private:
+    static int open(uint32_t type, uint64_t config)
+    {
+        perf_event_attr attributes;
+        std::memset(&attributes, 0, sizeof(attributes));
+        attributes.size             = sizeof(attributes);
+        attributes.type             = type;
+        attributes.config           = config;
+        attributes.disabled         = 1;
+        attributes.exclude_kernel   = 1;
+        attributes.exclude_hv       = 1;
+
+        // Calling thread, any CPU
+        return static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+    }
+
+    std::array<int, COUNTER_COUNT> _fds;
+};
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "Transform.h"
+#include "Camera.h"
+
+// Singleton of the camera the scene is rendered from
+struct MainCamera
+{
+    Transform   transform;
+    Camera      camera;
+    glm::vec3   previousPosition {};    // At the previous simulation step
+};
@@ -7,6 +7,5 @@ struct PointLight
 {
     glm::vec3   color;
     float       range;
-    glm::vec4   position;
-    glm::vec4   positionVS;
+    glm::vec4   position;   // World space, filled by the renderer
 };
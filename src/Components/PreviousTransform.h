@@ -0,0 +1,12 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Transform at the previous simulation step
+// Rendering interpolates between it and the current Transform
+struct PreviousTransform
+{
+    glm::vec3 position;
+    glm::vec3 rotation;
+    glm::vec3 scale;
+};
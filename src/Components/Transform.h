@@ -2,9 +2,51 @@
 
 #include <glm/glm.hpp>
 
+#include <tuple>
+#include <type_traits>
+
+#include "../Core/Subsystems/ECS/ComponentStorage.h"
+
 struct Transform
 {
     glm::vec3 position;
     glm::vec3 rotation;
     glm::vec3 scale;
 };
+
+// Proxy of a Transform stored field by field, keeps the transform.position syntax
+template<bool Const>
+struct TransformProxy
+{
+    template<typename V>
+    using Field = std::conditional_t<Const, const V&, V&>;
+
+    Field<glm::vec3> position;
+    Field<glm::vec3> rotation;
+    Field<glm::vec3> scale;
+
+    operator Transform() const
+    {
+        return { position, rotation, scale };
+    }
+
+    const TransformProxy& operator=(const Transform& transform) const requires (!Const)
+    {
+        position = transform.position;
+        rotation = transform.rotation;
+        scale    = transform.scale;
+        return *this;
+    }
+};
+
+using TransformRef      = TransformProxy<false>;
+using ConstTransformRef = TransformProxy<true>;
+
+// Most loops only touch the position, they read its array rather than whole transforms
+template<>
+struct SoALayout<Transform> : std::true_type
+{
+    static constexpr auto fields = std::make_tuple(&Transform::position, &Transform::rotation, &Transform::scale);
+    using Ref      = TransformRef;
+    using ConstRef = ConstTransformRef;
+};
@@ -3,132 +3,328 @@
 #include "../Components/Transform.h"
 #include "../Components/Camera.h"
 #include "../Components/PointLight.h"
+#include "../Components/MainCamera.h"
+#include "../Components/PreviousTransform.h"
 
 #include "../Systems/CameraHandler.h"
 #include "../Systems/PointLightsHandler.h"
+#include "../Systems/InterpolationHandler.h"
 
 #include "Subsystems/ECS/ECSManager.h"
 #include "Subsystems/Window/Window.h"
 #include "Subsystems/Renderer/Renderer.h"
+#include "Subsystems/Input/InputManager.h"
+#include "Subsystems/Benchmark/CameraSpline.h"
+#include "Subsystems/Memory/FrameArena.h"
+#include "Subsystems/Memory/AllocationCounter.h"
+#include "Subsystems/Memory/MemoryTracker.h"
 
+#include <algorithm>
+#include <cmath>
 #include <random>
 
 ECSManager          g_ECSManager;
 Window              g_Window;
 Renderer            g_Renderer;
-auto                g_Camera      = g_ECSManager.registerSystem<CameraHandler>();
+CameraHandler       g_Camera;
 auto                g_PointLights = g_ECSManager.registerSystem<PointLightsHandler>();
+auto                g_Interpolation = g_ECSManager.registerSystem<InterpolationHandler>();
 
-int Core::Run()
+const uint32_t  BENCHMARK_SEED  = 42;
+
+// Seconds between two reports of the memory usage
+const float     MEMORY_REPORT_PERIOD = 10.0f;
+
+int Core::Run(int argc, char** argv)
 {
-    RegisterAllComponents();
+    const BenchmarkSettings settings = parseCommandLine(argc, argv);
 
-    // Camera system initialization
-    const Signature cameraSignature = [&](){
-        Signature s;
-        s.set(g_ECSManager.getComponentType<Transform>());
-        s.set(g_ECSManager.getComponentType<Camera>());
-        return s;
-    }();
-    g_ECSManager.setSystemSignature<CameraHandler>(cameraSignature);
+    RegisterAllComponents();
 
     // Light system initialization
-    const Signature pointLightsSignature = [&]() {
-        Signature s;
-        s.set(g_ECSManager.getComponentType<Transform>());
-        s.set(g_ECSManager.getComponentType<PointLight>());
-        return s;
-    }();
-    g_ECSManager.setSystemSignature<PointLightsHandler>(pointLightsSignature);
-
-    Entity mainEntity = g_ECSManager.createEntity();
-    g_ECSManager.addComponent
+    g_ECSManager.setSystemSignature<PointLightsHandler, Transform, PointLight>();
+
+    // Interpolation system initialization
+    g_ECSManager.setSystemSignature<InterpolationHandler, Transform, PreviousTransform>();
+
+    // The camera is global state rather than an entity
+    g_ECSManager.emplaceSingleton<MainCamera>
     (
-        mainEntity,
-        Transform
+        MainCamera
         {
-            .position = {9.5, 5.25, -0.275},
-            .rotation = glm::vec3(0, 0, 0),
-            .scale = glm::vec3(1.0f, 1.0f, 1.0f)
+            .transform = Transform
+            {
+                .position = {9.5, 5.25, -0.275},
+                .rotation = glm::vec3(0, 0, 0),
+                .scale = glm::vec3(1.0f, 1.0f, 1.0f)
+            },
+            .camera = Camera{}
         }
     );
 
-    g_ECSManager.addComponent
-    (
-        mainEntity,
-        Camera{}
-    );
+    g_Renderer.loadWorld(settings.scene, settings.keepGeometry);
 
-    std::vector<Entity> entities(32768);
-    srand(static_cast <unsigned> (time(0)));
-    
-    for (auto& entity : entities)
+    if (settings.enabled)
     {
-        // should use uniform_real_distribution
-        float x = (static_cast<float>(rand()) / static_cast<float>(RAND_MAX)) * 23.0 - 23.0 / 2.0;
-        float y = (static_cast<float>(rand()) / static_cast<float>(RAND_MAX)) * 7 + 0.5f;
-        float z = (static_cast<float>(rand()) / static_cast<float>(RAND_MAX)) * 11.0 - 11.0 / 2.0;
-
-        float r = static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
-        float g = static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
-        float b = static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
-        float k = 10.0f;
+        return RunBenchmark(settings);
+    }
 
-        entity = g_ECSManager.createEntity();
-        
-        g_ECSManager.addComponent
-        (
-            entity,
-            Transform
-            {
-                .position = {x, -5, z},
-                .rotation = glm::vec3(0, 0, 0),
-                .scale = glm::vec3(1.0f, 1.0f, 1.0f)
-            }
-        );
-        g_ECSManager.addComponent
-        (
-            entity,
-            PointLight
-            {
-                .color = {r * k, g * k, b * k},
-                .range = 0.4f,
-                .position = glm::vec4(1),   // ignored
-                .positionVS = glm::vec4(1)  // ignored
-            }
-        );
+    // A replay spawns the lights of the recorded session
+    uint32_t seed = static_cast<uint32_t>(time(0));
+    if (!settings.replayPath.empty())
+    {
+        if (!InputManager::startReplay(settings.replayPath))
+        {
+            return EXIT_FAILURE;
+        }
+        seed = InputManager::sessionSeed();
+    }
+    else if (!settings.recordPath.empty() && !InputManager::startRecording(settings.recordPath, seed))
+    {
+        return EXIT_FAILURE;
     }
 
+    SpawnLights(g_Renderer.maxLights(), seed);
+
     // Important //
-    g_Camera->Update(0);
-    g_Renderer.init();
+    uint32_t width, height;
+    g_Window.windowGetFramebufferSize(width, height);
+    g_Renderer.setOutputResolution(width, height);
+    g_Renderer.setLightCulling(settings.lightCullings.front());
+    g_Renderer.setLightListLayout(settings.lightListLayouts.front());
+    g_PointLights->setAnimated(settings.lightMotions.front() == LightMotion::Moving);
+    g_Renderer.setDynamicResolution(settings.targetFrameTime > 0.0f, settings.targetFrameTime);
+    g_Camera.Update(0);
 
+    // The simulation of a frame overlaps the drawing of the previous one
+    if (settings.renderThread)
+    {
+        _renderThread = std::make_unique<RenderThread>(g_Window, g_Renderer);
+    }
+
+    // The simulation runs at a fixed rate, the frames render between its last two steps
+    const float tickDt = 1.0f / settings.tickRate;
+    float accumulator = 0.0f;
     float dt = 0.0f;
+    float memoryReportTime = 0.0f;
 
-    while (!g_Window.windowShouldClose())
+    while (!g_Window.windowShouldClose() && !InputManager::replayFinished())
     {
         const auto startTime = std::chrono::high_resolution_clock::now();
 
-        g_Camera->Update(dt);
-        g_PointLights->Update(dt);
+        // A replay steps once per frame so it does not depend on the frame rate
+        accumulator += InputManager::replaying() ? tickDt : dt;
+        uint32_t steps = 0;
+        while (accumulator >= tickDt && steps < settings.maxCatchUpSteps)
+        {
+            Step(tickDt);
+            accumulator -= tickDt;
+            ++steps;
+        }
 
-        g_Renderer.drawFrame();
+        // Too far behind, drop the late steps rather than falling further behind
+        if (accumulator >= tickDt)
+        {
+            accumulator = std::fmod(accumulator, tickDt);
+        }
 
-        g_Window.pollEvents();
-        g_Window.swapBuffers();
+        Render(accumulator / tickDt, dt);
 
         const auto stopTime = std::chrono::high_resolution_clock::now();
 		dt = std::chrono::duration<float, std::chrono::seconds::period>(stopTime - startTime).count();
         INFO("FPS: " << 1.0/dt);
+
+        memoryReportTime += dt;
+        if (memoryReportTime >= MEMORY_REPORT_PERIOD)
+        {
+            MemoryTracker::report();
+            memoryReportTime = 0.0f;
+        }
     }
 
+    _renderThread.reset();
+    MemoryTracker::report();
+    InputManager::stopRecording(_time);
+
     return EXIT_SUCCESS;  
 }
 
+// Random lights in the bounds of the scene, spawned at once
+std::vector<Entity> Core::SpawnLights(const uint64_t count, const uint32_t seed) const
+{
+    std::vector<Transform> transforms(count);
+    std::vector<PreviousTransform> previousTransforms(count);
+    std::vector<PointLight> pointLights(count);
+
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        float x = unit(generator) * 23.0 - 23.0 / 2.0;
+        float z = unit(generator) * 11.0 - 11.0 / 2.0;
+
+        float r = unit(generator);
+        float g = unit(generator);
+        float b = unit(generator);
+        float k = 10.0f;
+
+        transforms[i] = Transform
+        {
+            .position = {x, -5, z},
+            .rotation = glm::vec3(0, 0, 0),
+            .scale = glm::vec3(1.0f, 1.0f, 1.0f)
+        };
+        previousTransforms[i] = PreviousTransform
+        {
+            .position = transforms[i].position,
+            .rotation = transforms[i].rotation,
+            .scale = transforms[i].scale
+        };
+        pointLights[i] = PointLight
+        {
+            .color = {r * k, g * k, b * k},
+            .range = 0.4f,
+            .position = glm::vec4(1)    // ignored
+        };
+    }
+
+    const std::vector<Entity> entities = g_ECSManager.createEntities(count);
+    g_ECSManager.addComponents<Transform, PreviousTransform, PointLight>(entities, transforms, previousTransforms, pointLights);
+    return entities;
+}
+
+// One simulation step
+void Core::Step(const float dt)
+{
+    InputManager::beginStep(_time);
+
+    g_Interpolation->Update();
+    g_Camera.Update(dt);
+    g_PointLights->Update(dt);
+
+    // Structural changes recorded by the systems
+    g_ECSManager.playback();
+
+    _time += dt;
+}
+
+// Render the state at alpha between the last two simulation steps
+void Core::Render(const float alpha, const float frameTime)
+{
+    if (_renderThread)
+    {
+        g_Renderer.buildFramePacket(_renderThread->acquire(), alpha, frameTime);
+        _renderThread->submit();
+    }
+    else
+    {
+        g_Renderer.buildFramePacket(_framePacket, alpha, frameTime);
+        g_Renderer.drawFrame(_framePacket);
+        g_Window.swapBuffers();
+    }
+
+    g_Window.pollEvents();
+    g_ECSManager.advanceChangeTick();
+
+    // The frame scratch memory of the simulation thread
+    FrameArena::local().reset();
+}
+
+// Runs of every combination of the swept settings, in a hidden window
+int Core::RunBenchmark(const BenchmarkSettings& settings)
+{
+    CameraSpline spline;
+    if (!settings.cameraPath.empty() && !spline.load(settings.cameraPath))
+    {
+        return EXIT_FAILURE;
+    }
+
+    g_Window.setVisible(false);
+    g_Window.setSize(settings.width, settings.height);
+    g_Renderer.setOutputResolution(settings.width, settings.height);
+    g_Renderer.setMaxLights(*std::max_element(settings.lightCounts.begin(), settings.lightCounts.end()));
+    g_Camera.setScripted(true);
+    g_Camera.Update(0);
+    g_Renderer.setGpuTiming(true);
+    g_Renderer.setDynamicResolution(settings.targetFrameTime > 0.0f, settings.targetFrameTime);
+
+    FrameBenchmark benchmark(settings);
+    std::vector<Entity> lights;
+
+    for (const auto& run : benchmarkRuns(settings))
+    {
+        g_Renderer.setLightCulling(run.lightCulling);
+        g_Renderer.setLightListLayout(run.lightListLayout);
+        g_PointLights->setAnimated(run.lightMotion == LightMotion::Moving);
+
+        for (const auto entity : lights)
+        {
+            g_ECSManager.destroyEntity(entity);
+        }
+        lights = SpawnLights(run.lightCount, BENCHMARK_SEED);
+
+        RunBenchmarkFrames(settings, spline, benchmark, run);
+    }
+
+    return benchmark.write() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Warm-up then measured frames of a run
+// Each frame renders one simulation step, on the main thread for the pass timings
+// The camera follows the recorded path over the measured frames
+// The dynamic resolution follows the measured frame times
+void Core::RunBenchmarkFrames(const BenchmarkSettings& settings, const CameraSpline& spline, FrameBenchmark& benchmark, const BenchmarkRun& run)
+{
+    const float tickDt = 1.0f / settings.tickRate;
+    float frameTime = tickDt;
+    const uint32_t frameCount = settings.warmupFrames + settings.measuredFrames;
+    for (uint32_t frame = 0; frame < frameCount; ++frame)
+    {
+        if (frame == settings.warmupFrames)
+        {
+            g_Renderer.takePassTimings(true);
+            benchmark.beginRun(run);
+        }
+
+        // The warm-up frames loop over the path too
+        if (!spline.empty())
+        {
+            const uint32_t pathFrame = frame < settings.warmupFrames ? frame % settings.measuredFrames : frame - settings.warmupFrames;
+            const float progress = static_cast<float>(pathFrame) / std::max(settings.measuredFrames - 1, 1u);
+            const CameraKey key = spline.sample(spline.startTime() + progress * spline.duration());
+
+            auto& mainCamera = g_ECSManager.singleton<MainCamera>();
+            mainCamera.transform.position = key.position;
+            mainCamera.camera.yaw = key.yaw;
+            mainCamera.camera.pitch = key.pitch;
+        }
+
+        const uint64_t allocations = AllocationCounter::allocations();
+        const auto startTime = std::chrono::high_resolution_clock::now();
+        Step(tickDt);
+        Render(1.0f, frameTime);
+        const auto stopTime = std::chrono::high_resolution_clock::now();
+        frameTime = std::chrono::duration<float, std::chrono::seconds::period>(stopTime - startTime).count();
+
+        if (frame >= settings.warmupFrames)
+        {
+            benchmark.addCpuFrame(std::chrono::duration<double, std::milli>(stopTime - startTime).count());
+            benchmark.addHeapAllocations(AllocationCounter::allocations() - allocations);
+            benchmark.addPassTimings(g_Renderer.takePassTimings(false));
+            benchmark.addLightCullingStats(g_Renderer.lightCullingStats());
+        }
+    }
+
+    benchmark.addPassTimings(g_Renderer.takePassTimings(true));
+    benchmark.endRun();
+    MemoryTracker::report();
+}
+
 void Core::RegisterAllComponents() const
 {
     g_ECSManager.registerComponent<Transform>();
-    g_ECSManager.registerComponent<Camera>();
     g_ECSManager.registerComponent<PointLight>();
+    g_ECSManager.registerComponent<PreviousTransform>();
 }
 
@@ -1,12 +1,32 @@
 #pragma once
 
+#include "types.h"
+#include "Subsystems/Benchmark/FrameBenchmark.h"
+#include "Subsystems/Renderer/RenderThread.h"
+
 #include <chrono>
+#include <memory>
+#include <vector>
+
+class CameraSpline;
 
 class Core
 {
  public:
-     int Run();
+     int Run(int argc, char** argv);
 
  private:
      void RegisterAllComponents() const;
+     std::vector<Entity> SpawnLights(const uint64_t count, const uint32_t seed) const;
+     void Step(const float dt);
+     void Render(const float alpha, const float frameTime);
+     int RunBenchmark(const BenchmarkSettings& settings);
+     void RunBenchmarkFrames(const BenchmarkSettings& settings, const CameraSpline& spline, FrameBenchmark& benchmark, const BenchmarkRun& run);
+
+     // Simulated time of the current frame
+     float _time = 0.0f;
+
+     // Draws the frames when running, else they are drawn in turn with the simulation
+     std::unique_ptr<RenderThread> _renderThread;
+     FramePacket _framePacket;
 };
@@ -0,0 +1,106 @@
+#include "CameraSpline.h"
+
+#include "../../utils.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+bool CameraSpline::load(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        ERROR("Failed to open camera path " << path << '.');
+        return false;
+    }
+
+    _keys.clear();
+    std::string line;
+    uint32_t lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        ++lineNumber;
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+
+        CameraKey key;
+        std::istringstream stream(line);
+        if (!(stream >> key.time >> key.position.x >> key.position.y >> key.position.z >> key.yaw >> key.pitch))
+        {
+            ERROR("Invalid camera key at " << path << ':' << lineNumber << '.');
+            return false;
+        }
+        if (!_keys.empty() && key.time < _keys.back().time)
+        {
+            ERROR("Camera keys not sorted by time at " << path << ':' << lineNumber << '.');
+            return false;
+        }
+        _keys.push_back(key);
+    }
+
+    if (_keys.empty())
+    {
+        ERROR("Empty camera path " << path << '.');
+        return false;
+    }
+    return true;
+}
+
+bool CameraSpline::empty() const
+{
+    return _keys.empty();
+}
+
+float CameraSpline::startTime() const
+{
+    return _keys.empty() ? 0.0f : _keys.front().time;
+}
+
+float CameraSpline::duration() const
+{
+    return _keys.empty() ? 0.0f : _keys.back().time - _keys.front().time;
+}
+
+template<typename T>
+static T catmullRom(const T& p0, const T& p1, const T& p2, const T& p3, const float t)
+{
+    const float t2 = t * t;
+    const float t3 = t2 * t;
+    return 0.5f * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+}
+
+CameraKey CameraSpline::sample(const float time) const
+{
+    if (_keys.size() == 1 || time <= _keys.front().time)
+    {
+        return _keys.front();
+    }
+    if (time >= _keys.back().time)
+    {
+        return _keys.back();
+    }
+
+    // Segment [i, i + 1] containing the time, its neighbours clamped to the ends
+    const auto next = std::upper_bound(_keys.begin(), _keys.end(), time, [](const float t, const CameraKey& key)
+    {
+        return t < key.time;
+    });
+    const uint64_t i = (next - _keys.begin()) - 1;
+    const CameraKey& k0 = _keys[i == 0 ? 0 : i - 1];
+    const CameraKey& k1 = _keys[i];
+    const CameraKey& k2 = _keys[i + 1];
+    const CameraKey& k3 = _keys[std::min(i + 2, _keys.size() - 1)];
+
+    const float length = k2.time - k1.time;
+    const float t = length > 0.0f ? (time - k1.time) / length : 0.0f;
+
+    CameraKey key;
+    key.time     = time;
+    key.position = catmullRom(k0.position, k1.position, k2.position, k3.position, t);
+    key.yaw      = catmullRom(k0.yaw, k1.yaw, k2.yaw, k3.yaw, t);
+    key.pitch    = glm::clamp(catmullRom(k0.pitch, k1.pitch, k2.pitch, k3.pitch, t), -89.99f, 89.99f);
+    return key;
+}
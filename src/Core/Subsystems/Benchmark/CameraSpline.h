@@ -0,0 +1,34 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+// Camera pose at a time of the path
+struct CameraKey
+{
+    float       time;
+    glm::vec3   position;
+    float       yaw;
+    float       pitch;
+};
+
+// Recorded camera path, interpolated with a Catmull-Rom spline
+// Text file of one "time x y z yaw pitch" key per line, sorted by time,
+// lines starting with '#' are comments
+class CameraSpline
+{
+ public:
+    bool load(const std::string& path);
+
+    bool empty() const;
+    float startTime() const;
+    float duration() const;
+
+    // Pose at a time, clamped to the path
+    CameraKey sample(const float time) const;
+
+ private:
+    std::vector<CameraKey> _keys;
+};
@@ -0,0 +1,444 @@
+#include "FrameBenchmark.h"
+
+#include "../../utils.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+
+#define USAGE \
+    "Usage: cowboy-engine [--scene path] [--record path | --replay path] [--tick-rate hz] [--max-catch-up n] [--single-thread] [--keep-geometry] " \
+    "[--light-culling grid|bvh,...] [--light-list per-tile-cap|compact,...] [--light-motion moving|static,...] " \
+    "[--target-frame-ms ms] " \
+    "[--benchmark [--resolution WxH] [--lights n,n,...] " \
+    "[--camera path] [--warmup n] [--frames n] [--output file.csv|file.json]]"
+
+static uint64_t parseUnsigned(const char* text, const char* option)
+{
+    char* end = nullptr;
+    errno = 0;
+    const uint64_t value = std::strtoull(text, &end, 10);
+    if (end == text || *end != '\0' || errno != 0)
+    {
+        ERROR_EXIT("Invalid value " << text << " for " << option << ".\n" << USAGE);
+    }
+    return value;
+}
+
+static float parseFloat(const char* text, const char* option)
+{
+    char* end = nullptr;
+    errno = 0;
+    const float value = std::strtof(text, &end);
+    if (end == text || *end != '\0' || errno != 0 || !std::isfinite(value))
+    {
+        ERROR_EXIT("Invalid value " << text << " for " << option << ".\n" << USAGE);
+    }
+    return value;
+}
+
+// Values of an option separated by commas
+static std::vector<std::string> splitList(const std::string& list)
+{
+    std::vector<std::string> values;
+    uint64_t first = 0;
+    while (first <= list.size())
+    {
+        const uint64_t last = std::min(list.find(',', first), list.size());
+        values.push_back(list.substr(first, last - first));
+        first = last + 1;
+    }
+    return values;
+}
+
+BenchmarkSettings parseCommandLine(int argc, char** argv)
+{
+    BenchmarkSettings settings;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* option = argv[i];
+        if (std::strcmp(option, "--benchmark") == 0)
+        {
+            settings.enabled = true;
+            continue;
+        }
+        if (std::strcmp(option, "--single-thread") == 0)
+        {
+            settings.renderThread = false;
+            continue;
+        }
+        if (std::strcmp(option, "--keep-geometry") == 0)
+        {
+            settings.keepGeometry = true;
+            continue;
+        }
+
+        // Every other option takes a value
+        if (i + 1 >= argc)
+        {
+            ERROR_EXIT("Missing value for " << option << ".\n" << USAGE);
+        }
+        const char* value = argv[++i];
+
+        if (std::strcmp(option, "--scene") == 0)
+        {
+            settings.scene = value;
+        }
+        else if (std::strcmp(option, "--record") == 0)
+        {
+            settings.recordPath = value;
+        }
+        else if (std::strcmp(option, "--replay") == 0)
+        {
+            settings.replayPath = value;
+        }
+        else if (std::strcmp(option, "--tick-rate") == 0)
+        {
+            settings.tickRate = parseUnsigned(value, option);
+        }
+        else if (std::strcmp(option, "--max-catch-up") == 0)
+        {
+            settings.maxCatchUpSteps = parseUnsigned(value, option);
+        }
+        else if (std::strcmp(option, "--resolution") == 0)
+        {
+            const std::string resolution = value;
+            const uint64_t separator = resolution.find('x');
+            if (separator == std::string::npos)
+            {
+                ERROR_EXIT("Invalid resolution " << value << ".\n" << USAGE);
+            }
+            settings.width  = parseUnsigned(resolution.substr(0, separator).c_str(), option);
+            settings.height = parseUnsigned(resolution.substr(separator + 1).c_str(), option);
+        }
+        else if (std::strcmp(option, "--lights") == 0)
+        {
+            settings.lightCounts.clear();
+            for (const auto& count : splitList(value))
+            {
+                settings.lightCounts.push_back(parseUnsigned(count.c_str(), option));
+            }
+        }
+        else if (std::strcmp(option, "--light-culling") == 0)
+        {
+            settings.lightCullings.clear();
+            for (const auto& name : splitList(value))
+            {
+                if (name == "grid")
+                {
+                    settings.lightCullings.push_back(LightCulling::Grid);
+                }
+                else if (name == "bvh")
+                {
+                    settings.lightCullings.push_back(LightCulling::BVH);
+                }
+                else
+                {
+                    ERROR_EXIT("Invalid light culling " << name << ".\n" << USAGE);
+                }
+            }
+        }
+        else if (std::strcmp(option, "--light-list") == 0)
+        {
+            settings.lightListLayouts.clear();
+            for (const auto& name : splitList(value))
+            {
+                if (name == "per-tile-cap")
+                {
+                    settings.lightListLayouts.push_back(LightListLayout::PerTileCap);
+                }
+                else if (name == "compact")
+                {
+                    settings.lightListLayouts.push_back(LightListLayout::Compact);
+                }
+                else
+                {
+                    ERROR_EXIT("Invalid light list layout " << name << ".\n" << USAGE);
+                }
+            }
+        }
+        else if (std::strcmp(option, "--light-motion") == 0)
+        {
+            settings.lightMotions.clear();
+            for (const auto& name : splitList(value))
+            {
+                if (name == "moving")
+                {
+                    settings.lightMotions.push_back(LightMotion::Moving);
+                }
+                else if (name == "static")
+                {
+                    settings.lightMotions.push_back(LightMotion::Static);
+                }
+                else
+                {
+                    ERROR_EXIT("Invalid light motion " << name << ".\n" << USAGE);
+                }
+            }
+        }
+        else if (std::strcmp(option, "--target-frame-ms") == 0)
+        {
+            settings.targetFrameTime = parseFloat(value, option) / 1000.0f;
+        }
+        else if (std::strcmp(option, "--camera") == 0)
+        {
+            settings.cameraPath = value;
+        }
+        else if (std::strcmp(option, "--warmup") == 0)
+        {
+            settings.warmupFrames = parseUnsigned(value, option);
+        }
+        else if (std::strcmp(option, "--frames") == 0)
+        {
+            settings.measuredFrames = parseUnsigned(value, option);
+        }
+        else if (std::strcmp(option, "--output") == 0)
+        {
+            settings.output = value;
+        }
+        else
+        {
+            ERROR_EXIT("Unknown option " << option << ".\n" << USAGE);
+        }
+    }
+
+    if (settings.width == 0 || settings.height == 0 || settings.measuredFrames == 0)
+    {
+        ERROR_EXIT("The resolution and the measured frames must not be zero.\n" << USAGE);
+    }
+    if (settings.tickRate == 0 || settings.maxCatchUpSteps == 0)
+    {
+        ERROR_EXIT("The tick rate and the catch-up steps must not be zero.\n" << USAGE);
+    }
+    if (settings.targetFrameTime < 0.0f)
+    {
+        ERROR_EXIT("The target frame time must not be negative.\n" << USAGE);
+    }
+    if (!settings.recordPath.empty() && !settings.replayPath.empty())
+    {
+        ERROR_EXIT("Cannot record and replay at the same time.\n" << USAGE);
+    }
+
+    return settings;
+}
+
+std::vector<BenchmarkRun> benchmarkRuns(const BenchmarkSettings& settings)
+{
+    std::vector<BenchmarkRun> runs;
+    for (const auto lightCulling : settings.lightCullings)
+    {
+        for (const auto lightListLayout : settings.lightListLayouts)
+        {
+            for (const auto lightMotion : settings.lightMotions)
+            {
+                for (const auto lightCount : settings.lightCounts)
+                {
+                    runs.push_back({ lightCulling, lightListLayout, lightMotion, lightCount });
+                }
+            }
+        }
+    }
+    return runs;
+}
+
+SampleStats computeStats(std::vector<double> samples)
+{
+    SampleStats stats;
+    if (samples.empty())
+    {
+        return stats;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    const auto percentile = [&samples](const double p)
+    {
+        const uint64_t rank = static_cast<uint64_t>(std::ceil(p / 100.0 * samples.size()));
+        return samples[std::clamp<uint64_t>(rank, 1, samples.size()) - 1];
+    };
+
+    stats.mean  = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+    stats.min   = samples.front();
+    stats.p50   = percentile(50.0);
+    stats.p90   = percentile(90.0);
+    stats.p95   = percentile(95.0);
+    stats.p99   = percentile(99.0);
+    stats.max   = samples.back();
+    return stats;
+}
+
+FrameBenchmark::FrameBenchmark(const BenchmarkSettings& settings) : _settings(settings)
+{
+}
+
+static const char* lightMotionName(const LightMotion lightMotion)
+{
+    return lightMotion == LightMotion::Static ? "static" : "moving";
+}
+
+// Configuration of a run in the log
+static std::string runName(const BenchmarkRun& config)
+{
+    return std::string(lightCullingName(config.lightCulling)) + ", " + lightListLayoutName(config.lightListLayout) + ", "
+         + std::to_string(config.lightCount) + ' ' + lightMotionName(config.lightMotion) + " lights";
+}
+
+void FrameBenchmark::beginRun(const BenchmarkRun& config)
+{
+    Run& run = _runs.emplace_back();
+    run.config = config;
+    for (auto& samples : run.samples)
+    {
+        samples.reserve(_settings.measuredFrames);
+    }
+}
+
+void FrameBenchmark::addCpuFrame(const double milliseconds)
+{
+    _runs.back().samples[0].push_back(milliseconds);
+}
+
+void FrameBenchmark::addPassTimings(const std::vector<PassTimings>& timings)
+{
+    Run& run = _runs.back();
+    for (const auto& passes : timings)
+    {
+        for (uint32_t pass = 0; pass < RENDER_PASS_COUNT; ++pass)
+        {
+            run.samples[1 + pass].push_back(passes[pass]);
+        }
+        run.samples[GPU_FRAME_METRIC].push_back(std::accumulate(passes.begin(), passes.end(), 0.0));
+    }
+}
+
+void FrameBenchmark::addHeapAllocations(const uint64_t allocations)
+{
+    _runs.back().samples[HEAP_ALLOCATIONS_METRIC].push_back(static_cast<double>(allocations));
+}
+
+void FrameBenchmark::addLightCullingStats(const LightCullingStats& stats)
+{
+    _runs.back().samples[DROPPED_LIGHTS_METRIC].push_back(static_cast<double>(stats.droppedLightIndices));
+}
+
+void FrameBenchmark::endRun()
+{
+    const Run& run = _runs.back();
+    const SampleStats cpu = computeStats(run.samples[0]);
+    const SampleStats gpu = computeStats(run.samples[GPU_FRAME_METRIC]);
+    const SampleStats allocations = computeStats(run.samples[HEAP_ALLOCATIONS_METRIC]);
+    const SampleStats dropped = computeStats(run.samples[DROPPED_LIGHTS_METRIC]);
+    INFO(runName(run.config) << ": CPU " << cpu.p50 << " ms (p99 " << cpu.p99 << "), GPU " << gpu.p50 << " ms (p99 " << gpu.p99 << ')');
+    if (allocations.max > 0.0)
+    {
+        WARNING(runName(run.config) << ": " << allocations.mean << " heap allocations per frame (max " << allocations.max << ')');
+    }
+    if (dropped.max > 0.0)
+    {
+        WARNING(runName(run.config) << ": " << dropped.mean << " light indices dropped per frame (max " << dropped.max << ')');
+    }
+}
+
+bool FrameBenchmark::write() const
+{
+    std::ofstream file(_settings.output);
+    if (!file.is_open())
+    {
+        ERROR("Failed to open " << _settings.output << '.');
+        return false;
+    }
+
+    const std::string& output = _settings.output;
+    if (output.size() >= 5 && output.compare(output.size() - 5, 5, ".json") == 0)
+    {
+        writeJSON(file);
+    }
+    else
+    {
+        writeCSV(file);
+    }
+
+    OK("Benchmark results written to " << output);
+    return true;
+}
+
+const char* FrameBenchmark::metricName(const uint32_t metric)
+{
+    if (metric == 0)
+    {
+        return "cpuFrame";
+    }
+    if (metric == GPU_FRAME_METRIC)
+    {
+        return "gpuFrame";
+    }
+    if (metric == HEAP_ALLOCATIONS_METRIC)
+    {
+        return "heapAllocations";
+    }
+    if (metric == DROPPED_LIGHTS_METRIC)
+    {
+        return "droppedLightIndices";
+    }
+    return renderPassName(static_cast<RenderPass>(metric - 1));
+}
+
+void FrameBenchmark::writeCSV(std::ostream& stream) const
+{
+    stream << "culling,lightList,motion,lights,width,height,metric,samples,mean,min,p50,p90,p95,p99,max\n";
+    for (const auto& run : _runs)
+    {
+        for (uint32_t metric = 0; metric < METRIC_COUNT; ++metric)
+        {
+            const SampleStats stats = computeStats(run.samples[metric]);
+            stream << lightCullingName(run.config.lightCulling) << ',' << lightListLayoutName(run.config.lightListLayout) << ','
+                   << lightMotionName(run.config.lightMotion) << ',' << run.config.lightCount << ','
+                   << _settings.width << ',' << _settings.height << ','
+                   << metricName(metric) << ',' << run.samples[metric].size() << ','
+                   << stats.mean << ',' << stats.min << ',' << stats.p50 << ',' << stats.p90 << ','
+                   << stats.p95 << ',' << stats.p99 << ',' << stats.max << '\n';
+        }
+    }
+}
+
+void FrameBenchmark::writeJSON(std::ostream& stream) const
+{
+    // Paths are written as is, without escaping
+    stream << "{\n";
+    stream << "  \"scene\": \"" << _settings.scene << "\",\n";
+    stream << "  \"camera\": \"" << _settings.cameraPath << "\",\n";
+    stream << "  \"width\": " << _settings.width << ",\n";
+    stream << "  \"height\": " << _settings.height << ",\n";
+    stream << "  \"warmupFrames\": " << _settings.warmupFrames << ",\n";
+    stream << "  \"measuredFrames\": " << _settings.measuredFrames << ",\n";
+    stream << "  \"runs\": [\n";
+    for (uint64_t i = 0; i < _runs.size(); ++i)
+    {
+        const Run& run = _runs[i];
+        stream << "    {\n";
+        stream << "      \"culling\": \"" << lightCullingName(run.config.lightCulling) << "\",\n";
+        stream << "      \"lightList\": \"" << lightListLayoutName(run.config.lightListLayout) << "\",\n";
+        stream << "      \"motion\": \"" << lightMotionName(run.config.lightMotion) << "\",\n";
+        stream << "      \"lights\": " << run.config.lightCount << ",\n";
+        stream << "      \"metrics\": {\n";
+        for (uint32_t metric = 0; metric < METRIC_COUNT; ++metric)
+        {
+            const SampleStats stats = computeStats(run.samples[metric]);
+            stream << "        \"" << metricName(metric) << "\": { "
+                   << "\"samples\": " << run.samples[metric].size()
+                   << ", \"mean\": " << stats.mean << ", \"min\": " << stats.min
+                   << ", \"p50\": " << stats.p50 << ", \"p90\": " << stats.p90
+                   << ", \"p95\": " << stats.p95 << ", \"p99\": " << stats.p99
+                   << ", \"max\": " << stats.max << " }"
+                   << (metric + 1 < METRIC_COUNT ? ",\n" : "\n");
+        }
+        stream << "      }\n";
+        stream << "    }" << (i + 1 < _runs.size() ? ",\n" : "\n");
+    }
+    stream << "  ]\n";
+    stream << "}\n";
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "../Renderer/GpuTimer.h"
+#include "../Renderer/LightCulling.h"
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Lights animated by the PointLightsHandler or left where they spawned
+enum class LightMotion
+{
+    Moving,
+    Static,
+};
+
+// Launch options, the benchmark ones are only used with --benchmark
+struct BenchmarkSettings
+{
+    bool                         enabled          = false;
+    std::string                  scene            = "models/Sponza.gltf";
+    std::string                  recordPath;      // Input recording of the session
+    std::string                  replayPath;      // Input recording to replay
+    uint32_t                     tickRate         = 60;    // Simulation steps per second
+    uint32_t                     maxCatchUpSteps  = 5;     // Simulation steps per frame at most
+    bool                         renderThread     = true;  // Draw on a thread of its own, the benchmark never does
+    bool                         keepGeometry     = false; // Keep the CPU copies of the meshes once uploaded
+    float                        targetFrameTime  = 0.0f;  // Seconds held by the dynamic resolution, off at 0
+    uint32_t                     width            = 1280;
+    uint32_t                     height           = 720;
+    std::vector<uint64_t>        lightCounts      = { 32768 };
+    std::vector<LightCulling>    lightCullings    = { LightCulling::Grid };           // Swept by the benchmark, else the first one
+    std::vector<LightListLayout> lightListLayouts = { LightListLayout::PerTileCap };  // Swept by the benchmark, else the first one
+    std::vector<LightMotion>     lightMotions     = { LightMotion::Moving };          // Swept by the benchmark, else the first one
+    std::string                  cameraPath;      // Fixed camera when empty
+    uint32_t                     warmupFrames     = 100;
+    uint32_t                     measuredFrames   = 500;
+    std::string                  output           = "benchmark.csv";
+};
+
+// [--scene path] [--record path | --replay path] [--tick-rate hz] [--max-catch-up n] [--single-thread] [--keep-geometry]
+// [--light-culling grid|bvh,...] [--light-list per-tile-cap|compact,...] [--light-motion moving|static,...]
+// [--target-frame-ms ms]
+// [--benchmark [--resolution WxH] [--lights n,n,...] [--camera path]
+//              [--warmup n] [--frames n] [--output file.csv|file.json]]
+BenchmarkSettings parseCommandLine(int argc, char** argv);
+
+// Statistics of the samples of a metric, nearest rank percentiles
+struct SampleStats
+{
+    double mean = 0.0;
+    double min  = 0.0;
+    double p50  = 0.0;
+    double p90  = 0.0;
+    double p95  = 0.0;
+    double p99  = 0.0;
+    double max  = 0.0;
+};
+
+SampleStats computeStats(std::vector<double> samples);
+
+// Configuration of a run of the sweep
+struct BenchmarkRun
+{
+    LightCulling    lightCulling;
+    LightListLayout lightListLayout;
+    LightMotion     lightMotion;
+    uint64_t        lightCount;
+};
+
+// Every combination of the swept settings, the light count changing fastest
+std::vector<BenchmarkRun> benchmarkRuns(const BenchmarkSettings& settings);
+
+// Frame times of the runs of a sweep, in milliseconds
+// Written as CSV, or JSON when the output ends with .json
+class FrameBenchmark
+{
+ public:
+    explicit FrameBenchmark(const BenchmarkSettings& settings);
+
+    void beginRun(const BenchmarkRun& config);
+    void addCpuFrame(const double milliseconds);
+    void addPassTimings(const std::vector<PassTimings>& timings);
+    void addHeapAllocations(const uint64_t allocations);
+    void addLightCullingStats(const LightCullingStats& stats);
+    void endRun();
+
+    bool write() const;
+
+ private:
+    // CPU frame, GPU passes, whole GPU frame, heap allocations then light indices dropped by the culling
+    static const uint32_t GPU_FRAME_METRIC          = RENDER_PASS_COUNT + 1;
+    static const uint32_t HEAP_ALLOCATIONS_METRIC   = RENDER_PASS_COUNT + 2;
+    static const uint32_t DROPPED_LIGHTS_METRIC     = RENDER_PASS_COUNT + 3;
+    static const uint32_t METRIC_COUNT              = RENDER_PASS_COUNT + 4;
+
+    struct Run
+    {
+        BenchmarkRun                                    config;
+        std::array<std::vector<double>, METRIC_COUNT>   samples;
+    };
+
+    static const char* metricName(const uint32_t metric);
+
+    void writeCSV(std::ostream& stream) const;
+    void writeJSON(std::ostream& stream) const;
+
+    const BenchmarkSettings&    _settings;
+    std::vector<Run>            _runs;
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "./../../types.h"
+#include "./ComponentManager.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+enum class CommandType : uint8_t
+{
+    AddComponent,
+    RemoveComponent,
+    DestroyEntity
+};
+
+// Structural changes recorded by one thread during the frame
+// They are applied by ECSManager::playback() so systems can keep iterating
+// their entities while spawning and destroying
+class CommandBuffer
+{
+ public:
+    // Generation of the entities created by the buffer until playback
+    static constexpr uint32_t PENDING_GENERATION = std::numeric_limits<uint32_t>::max();
+
+    // Returns a placeholder only valid in the commands of this buffer
+    Entity createEntity()
+    {
+        return makeEntity(_createdCount++, PENDING_GENERATION);
+    }
+
+    void destroyEntity(Entity entity)
+    {
+        _commands.push_back({CommandType::DestroyEntity, 0, entity, 0});
+    }
+
+    // The component is copied into the buffer until playback
+    template<typename T>
+    void addComponent(Entity entity, const T& component)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Deferred components must be trivially copyable.");
+
+        const uint64_t offset = _payload.size();
+        _payload.resize(offset + sizeof(T));
+        std::memcpy(_payload.data() + offset, &component, sizeof(T));
+        _commands.push_back({CommandType::AddComponent, componentType<T>, entity, offset});
+    }
+
+    template<typename T>
+    void removeComponent(Entity entity)
+    {
+        _commands.push_back({CommandType::RemoveComponent, componentType<T>, entity, 0});
+    }
+
+    bool empty() const
+    {
+        return _commands.empty() && _createdCount == 0;
+    }
+
+ private:
+    friend class ECSManager;
+
+    struct Command
+    {
+        CommandType     type;
+        ComponentType   component;
+        Entity          entity;
+        uint64_t        payload;    // Offset of the component, add only
+    };
+
+    static bool isPending(Entity entity)
+    {
+        return entityGeneration(entity) == PENDING_GENERATION;
+    }
+
+    void clear()
+    {
+        _commands.clear();
+        _payload.clear();
+        _createdCount = 0;
+    }
+
+    std::vector<Command>    _commands;
+    std::vector<std::byte>  _payload;
+    EntityIndex             _createdCount = 0;
+};
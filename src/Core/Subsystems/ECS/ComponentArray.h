@@ -1,10 +1,15 @@
 #pragma once
 
 #include "./../../types.h"
+#include "./ComponentStorage.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <limits>
-#include <unordered_map>
+#include <memory>
+#include <span>
+#include <vector>
 #include <array>
 
 class IComponentArray
@@ -14,72 +19,233 @@ class IComponentArray
      virtual void entityDestroyed(Entity entity) = 0;
 };
 
+// Sparse set of components
+// The sparse side maps an entity to its dense index and is split in pages
+// allocated on first use, the dense side only holds the live components
+// Each component stores the change tick of its last mutable access
+// SoA components are handed out through their Ref/ConstRef proxies
 template<typename T>
 class ComponentArray : public IComponentArray
 {
  public:
+    using Storage   = ComponentStorage<T>;
+    using Ref       = typename Storage::Ref;
+    using ConstRef  = typename Storage::ConstRef;
+
+    // 4 KB of dense indices per page
+    static constexpr uint64_t PAGE_SIZE = 4096 / sizeof(uint32_t);
+    static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+    explicit ComponentArray(const uint64_t& changeTick) : _changeTick(changeTick) {}
+
     // Link entity and component
     void insert(Entity entity, T component)
     {
-        assert(_entityToIndexMap[entity] == std::numeric_limits<Entity>::max() && "Component added to same entity more than once.");
+        uint32_t& index = sparseIndex(entity);
+        assert(index == INVALID_INDEX && "Component added to same entity more than once.");
+        assert(_components.size() < INVALID_INDEX && "Reached components limit.");
+
+        index = static_cast<uint32_t>(_components.size());
+        _components.push_back(std::move(component));
+        _entities.push_back(entity);
+        _versions.push_back(_changeTick);
+        ++_structureVersion;
+    }
+
+    // Link a batch of entities and their components
+    void insert(std::span<const Entity> entities, std::span<const T> components)
+    {
+        assert(entities.size() == components.size() && "Entities and components count mismatch.");
+
+        insertEntities(entities);
+        _components.append(components);
+        _versions.insert(_versions.end(), entities.size(), _changeTick);
+    }
 
-        uint64_t newIndex = _size;
-        _entityToIndexMap[entity] = newIndex;
-        _indexToEntityMap[newIndex] = entity;
-        _componentArray[newIndex] = component;
-        ++_size;
+    // Link a batch of entities to copies of the same component
+    void insert(std::span<const Entity> entities, const T& component)
+    {
+        insertEntities(entities);
+        _components.append(entities.size(), component);
+        _versions.insert(_versions.end(), entities.size(), _changeTick);
     }
 
     // Remove entity and maintain array density
     void remove(Entity entity)
     {
-        assert(_entityToIndexMap[entity] != std::numeric_limits<Entity>::max() && "Trying to remove non-existent component.");
+        assert(contains(entity) && "Trying to remove non-existent component.");
 
-        // Copy element at end into deleted element's index
+        // Move element at end into deleted element's index
         // to maintain density
-        uint64_t indexRemovedEntity = _entityToIndexMap[entity];
-        uint64_t indexLastElement = _size - 1;
-        _componentArray[indexRemovedEntity] = _componentArray[indexLastElement];
+        uint32_t& indexRemovedEntity = sparseIndex(entity);
+        const Entity entityLastElement = _entities.back();
+        if (entityLastElement != entity)
+        {
+            _components.moveBackTo(indexRemovedEntity);
+            _entities[indexRemovedEntity] = entityLastElement;
+            _versions[indexRemovedEntity] = _changeTick;
+
+            // Update map to point to moved spot
+            sparseIndex(entityLastElement) = indexRemovedEntity;
+        }
+        indexRemovedEntity = INVALID_INDEX;
+
+        _components.pop_back();
+        _entities.pop_back();
+        _versions.pop_back();
+        ++_structureVersion;
+    }
+
+    // Return reference to entity's component, marking it as changed
+    Ref get(Entity entity)
+    {
+        const uint32_t index = denseIndex(entity);
+        _versions[index] = _changeTick;
+        return _components.at(index);
+    }
+
+    // Read only access, the component is not marked as changed
+    ConstRef get(Entity entity) const
+    {
+        return _components.at(denseIndex(entity));
+    }
+
+    // The component was mutably accessed after the given tick
+    bool changedSince(Entity entity, uint64_t tick) const
+    {
+        return _versions[denseIndex(entity)] > tick;
+    }
 
-        // Update map to point to moved spot
-        Entity entityLastElement = _indexToEntityMap[indexLastElement];
-        _entityToIndexMap[entityLastElement] = indexRemovedEntity;
-        _indexToEntityMap[indexRemovedEntity] = entityLastElement;
+    // Component at a dense index, marking it as changed
+    Ref at(uint32_t index)
+    {
+        _versions[index] = _changeTick;
+        return _components.at(index);
+    }
 
-        _entityToIndexMap[entity] = std::numeric_limits<Entity>::max();
-        _indexToEntityMap[indexLastElement] = std::numeric_limits<Entity>::max();
-        --_size;
+    ConstRef at(uint32_t index) const
+    {
+        return _components.at(index);
     }
 
-    // Return reference to entity's component
-    T& get(Entity entity)
+    // Dense index of the entity's component, INVALID_INDEX if it has none
+    uint32_t find(Entity entity) const
     {
-        assert(_entityToIndexMap[entity] != std::numeric_limits<Entity>::max() && "Trying to remove non-existent component.");
+        const EntityIndex index = entityIndex(entity);
+        const uint64_t page = index / PAGE_SIZE;
+        if (page >= _sparse.size() || !_sparse[page])
+        {
+            return INVALID_INDEX;
+        }
 
-        return _componentArray[_entityToIndexMap[entity]];
+        // The slot may hold an older generation of the entity
+        const uint32_t denseIndex = (*_sparse[page])[index % PAGE_SIZE];
+        return denseIndex != INVALID_INDEX && _entities[denseIndex] == entity ? denseIndex : INVALID_INDEX;
+    }
+
+    // Position of the entity's component in the packed arrays
+    uint32_t denseIndex(Entity entity) const
+    {
+        assert(contains(entity) && "Trying to get non-existent component.");
+
+        const EntityIndex index = entityIndex(entity);
+        return (*_sparse[index / PAGE_SIZE])[index % PAGE_SIZE];
+    }
+
+    bool contains(Entity entity) const
+    {
+        return find(entity) != INVALID_INDEX;
     }
 
     // Remove the entity's if it existed
     void entityDestroyed(Entity entity) override
     {
-        if (_entityToIndexMap[entity] != std::numeric_limits<Entity>::max())
+        if (contains(entity))
         {
             remove(entity);
         }
     }
 
+    uint64_t size() const
+    {
+        return _components.size();
+    }
+
+    // Packed arrays, a dense index addresses the same entity in all of them
+    std::span<const Entity>     entities()      const { return _entities; }
+    std::span<const uint64_t>   versions()      const { return _versions; }
+    const Storage&              storage()       const { return _components; }
+
+    std::span<const T> components() const requires (!SoALayout<T>::value)
+    {
+        return _components.data();
+    }
+
+    // Field I of the SoA components at the dense indices [first, first + count), marked as changed
+    template<uint64_t I>
+    auto field(uint64_t first, uint64_t count) requires (SoALayout<T>::value)
+    {
+        std::fill_n(_versions.begin() + first, count, _changeTick);
+        return _components.template field<I>().subspan(first, count);
+    }
+
+    // Bumped when components are inserted or removed, the dense indices may have moved
+    uint64_t structureVersion() const
+    {
+        return _structureVersion;
+    }
+
  private:
-    std::array<T, MAX_ENTITIES> _componentArray;
+    using Page = std::array<uint32_t, PAGE_SIZE>;
 
-    // Fill the array with invalid values
-    constexpr std::array<Entity, MAX_ENTITIES> initArrays()
+    // Dense index slot of an entity, allocating its page if needed
+    uint32_t& sparseIndex(Entity entity)
     {
-        std::array<Entity, MAX_ENTITIES> temp;
-        temp.fill(std::numeric_limits<Entity>::max());
-        return temp;
+        const EntityIndex index = entityIndex(entity);
+        const uint64_t page = index / PAGE_SIZE;
+        if (page >= _sparse.size())
+        {
+            _sparse.resize(page + 1);
+        }
+        if (!_sparse[page])
+        {
+            // Fill the page with invalid values
+            _sparse[page] = std::make_unique<Page>();
+            _sparse[page]->fill(INVALID_INDEX);
+        }
+        return (*_sparse[page])[index % PAGE_SIZE];
     }
 
-    std::array<Entity, MAX_ENTITIES> _entityToIndexMap = initArrays();
-    std::array<Entity, MAX_ENTITIES> _indexToEntityMap = initArrays();
-    uint64_t _size = 0;
+    // Append the entities to the dense side, their components follow
+    void insertEntities(std::span<const Entity> entities)
+    {
+        assert(_components.size() + entities.size() < INVALID_INDEX && "Reached components limit.");
+
+        uint32_t denseIndex = static_cast<uint32_t>(_components.size());
+        for (const auto entity : entities)
+        {
+            uint32_t& index = sparseIndex(entity);
+            assert(index == INVALID_INDEX && "Component added to same entity more than once.");
+            index = denseIndex++;
+        }
+        _entities.insert(_entities.end(), entities.begin(), entities.end());
+        ++_structureVersion;
+    }
+
+    std::vector<std::unique_ptr<Page>> _sparse;
+
+    // Components, their entities and change ticks, packed
+    Storage                 _components;
+    std::vector<Entity>     _entities;
+    std::vector<uint64_t>   _versions;
+
+    const uint64_t& _changeTick;
+    uint64_t        _structureVersion = 0;
 };
+
+// Reference to a component as handed out by the ECS
+// A proxy for SoA components, const T giving read only access
+template<typename T>
+using ComponentRef = std::conditional_t<std::is_const_v<T>,
+                                        typename ComponentArray<std::remove_const_t<T>>::ConstRef,
+                                        typename ComponentArray<std::remove_const_t<T>>::Ref>;
@@ -4,6 +4,35 @@
 #include "./ComponentArray.h"
 
 #include <memory>
+#include <array>
+#include <span>
+
+// Sequential component type IDs, one per component type
+class ComponentTypeCounter
+{
+ public:
+    static ComponentType next()
+    {
+        assert(_next < MAX_COMPONENTS && "Reached component types limit.");
+        return _next++;
+    }
+
+ private:
+    static inline ComponentType _next = 0;
+};
+
+// ID of the component type T, assigned once at startup
+template<typename T>
+inline const ComponentType componentType = ComponentTypeCounter::next();
+
+// Signature of a component list
+template<typename... Ts>
+Signature signatureOf()
+{
+    Signature signature;
+    (signature.set(componentType<Ts>), ...);
+    return signature;
+}
 
 class ComponentManager
 {
@@ -11,30 +40,19 @@ class ComponentManager
     template<typename T>
     void registerComponent()
     {
-        const char* typeName = typeid(T).name();
-
-        assert(_componentTypes.find(typeName) == _componentTypes.end() && "Registering component type more than once.");
-        
-        // Add the component type to the component type map
-        _componentTypes.insert({typeName, _nextComponentType});
+        assert(_componentArrays[componentType<T>] == nullptr && "Registering component type more than once.");
 
-        // Create a ComponentArray pointer and add it to the component array
-        // map
-        _componentArrays.insert({typeName, std::make_shared<ComponentArray<T>>()});
-
-        // Increment the next component type id
-        ++_nextComponentType;
+        // Create the ComponentArray at the slot of the component type
+        _componentArrays[componentType<T>] = std::make_unique<ComponentArray<T>>(_changeTick);
     }
 
     template<typename T>
-    ComponentType getComponentType()
+    ComponentType getComponentType() const
     {
-        const char* typeName = typeid(T).name();
-
-        assert(_componentTypes.find(typeName) != _componentTypes.end() && "Component not registered before use.");
+        assert(_componentArrays[componentType<T>] != nullptr && "Component not registered before use.");
 
         // Return this component's type
-        return _componentTypes[typeName];
+        return componentType<T>;
     }
 
     // Add a component to the array for an entity
@@ -44,47 +62,83 @@ class ComponentManager
         getComponentArray<T>()->insert(entity, component); 
     }
 
+    // Add the components of a batch of entities
+    template<typename T>
+    void addComponents(std::span<const Entity> entities, std::span<const T> components)
+    {
+        getComponentArray<T>()->insert(entities, components);
+    }
+
+    // Add copies of the same component to a batch of entities
+    template<typename T>
+    void addComponents(std::span<const Entity> entities, const T& component)
+    {
+        getComponentArray<T>()->insert(entities, component);
+    }
+
     // Remove a component from the array for an entity
     template<typename T>
-    void removeComponent(Entity entity, T component)
+    void removeComponent(Entity entity)
     {
-        getComponentArray<T>()->remove(entity, component); 
+        getComponentArray<T>()->remove(entity); 
     }
 
     // Get a reference to a component from the array for an entity
     template<typename T>
-    T& getComponent(Entity entity)
+    ComponentRef<T> getComponent(Entity entity)
+    {
+        return getComponentArray<T>()->get(entity);
+    }
+
+    template<typename T>
+    ComponentRef<const T> getComponent(Entity entity) const
     {
         return getComponentArray<T>()->get(entity);
     }
 
+    // Get statically casted pointer to the ComponentArray of type T
+    template<typename T>
+    ComponentArray<T>* getComponentArray()
+    {
+        assert(_componentArrays[componentType<T>] != nullptr && "Component not registered before use.");
+        return static_cast<ComponentArray<T>*>(_componentArrays[componentType<T>].get());
+    }
+
+    template<typename T>
+    const ComponentArray<T>* getComponentArray() const
+    {
+        assert(_componentArrays[componentType<T>] != nullptr && "Component not registered before use.");
+        return static_cast<const ComponentArray<T>*>(_componentArrays[componentType<T>].get());
+    }
+
+    // Mutable accesses stamp the components with the current tick
+    uint64_t changeTick() const
+    {
+        return _changeTick;
+    }
+
+    void advanceChangeTick()
+    {
+        ++_changeTick;
+    }
+
     // Notify each component array that an entity has been destroyed
     // If it has a component for that entity, it will remove it
     void entityDestroyed(Entity entity)
     {
-        for (const auto& pair : _componentArrays)
+        for (const auto& component : _componentArrays)
         {
-            const auto& component = pair.second;
-            component->entityDestroyed(entity);
+            if (component)
+            {
+                component->entityDestroyed(entity);
+            }
         }
     }
 
  private:
-    // Map from type string pointer to a component type
-    std::unordered_map<const char*, ComponentType> _componentTypes{};
+    // Component arrays indexed by component type
+    std::array<std::unique_ptr<IComponentArray>, MAX_COMPONENTS> _componentArrays{};
 
-    // Map from type string pointer to a component array
-    std::unordered_map<const char*, std::shared_ptr<IComponentArray>> _componentArrays{};
-
-    // The next component type starting at 0
-    ComponentType _nextComponentType{};
-
-    // Get statically casted pointer to the ComponentArray of type T
-    template<typename T>
-    std::shared_ptr<ComponentArray<T>> getComponentArray()
-    {
-        const char* typeName = typeid(T).name();
-        assert(_componentTypes.find(typeName) != _componentTypes.end() && "Component not registered before use.");
-        return std::static_pointer_cast<ComponentArray<T>> (_componentArrays[typeName]);
-    }
+    // Starts at 1 so everything is changed since tick 0
+    uint64_t _changeTick = 1;
 };
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+const uint64_t CACHE_LINE_SIZE = 64;
+
+// Components are stored as an array of structs unless SoALayout is specialized
+// A specialization derives from std::true_type, lists the fields to split in
+// per-field arrays and the proxies handed out in place of references:
+//     static constexpr auto fields = std::make_tuple(&T::a, &T::b);
+//     using Ref      = ...; // Aggregate of references to the fields, in order
+//     using ConstRef = ...; // Same with const references
+template<typename T>
+struct SoALayout : std::false_type {};
+
+// Allocator aligning the arrays on cache lines
+template<typename T>
+struct CacheLineAllocator
+{
+    using value_type = T;
+
+    CacheLineAllocator() = default;
+    template<typename U>
+    CacheLineAllocator(const CacheLineAllocator<U>&) {}
+
+    T* allocate(std::size_t count)
+    {
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(CACHE_LINE_SIZE)));
+    }
+
+    void deallocate(T* pointer, std::size_t)
+    {
+        ::operator delete(pointer, std::align_val_t(CACHE_LINE_SIZE));
+    }
+
+    template<typename U>
+    bool operator==(const CacheLineAllocator<U>&) const { return true; }
+};
+
+// Dense components as an array of structs
+template<typename T>
+class AoSStorage
+{
+ public:
+    using Ref       = T&;
+    using ConstRef  = const T&;
+
+    uint64_t size() const                           { return _data.size(); }
+    void push_back(T component)                     { _data.push_back(std::move(component)); }
+    void append(std::span<const T> components)      { _data.insert(_data.end(), components.begin(), components.end()); }
+    void append(uint64_t count, const T& component) { _data.insert(_data.end(), count, component); }
+    void moveBackTo(uint64_t index)                 { _data[index] = std::move(_data.back()); }
+    void pop_back()                                 { _data.pop_back(); }
+
+    Ref      at(uint64_t index)         { return _data[index]; }
+    ConstRef at(uint64_t index) const   { return _data[index]; }
+
+    std::span<const T> data() const     { return _data; }
+
+ private:
+    std::vector<T, CacheLineAllocator<T>> _data;
+};
+
+// Dense components split in one cache line aligned array per field
+// The split is per field, not per scalar, a vec3 field stays an array of vec3
+// and views still reach it through their dense indices
+template<typename T>
+class SoAStorage
+{
+ public:
+    using Ref       = typename SoALayout<T>::Ref;
+    using ConstRef  = typename SoALayout<T>::ConstRef;
+
+    static constexpr auto FIELDS = SoALayout<T>::fields;
+    static constexpr uint64_t FIELD_COUNT = std::tuple_size_v<decltype(FIELDS)>;
+
+    template<uint64_t I>
+    using Field = std::remove_reference_t<decltype(std::declval<T&>().*std::get<I>(FIELDS))>;
+
+    uint64_t size() const
+    {
+        return std::get<0>(_fields).size();
+    }
+
+    void push_back(const T& component)
+    {
+        forEachField([&](auto& array, auto member) { array.push_back(component.*member); });
+    }
+
+    void append(std::span<const T> components)
+    {
+        forEachField([&](auto& array, auto member)
+        {
+            array.reserve(array.size() + components.size());
+            for (const auto& component : components)
+            {
+                array.push_back(component.*member);
+            }
+        });
+    }
+
+    void append(uint64_t count, const T& component)
+    {
+        forEachField([&](auto& array, auto member) { array.insert(array.end(), count, component.*member); });
+    }
+
+    void moveBackTo(uint64_t index)
+    {
+        forEachField([&](auto& array, auto) { array[index] = std::move(array.back()); });
+    }
+
+    void pop_back()
+    {
+        forEachField([&](auto& array, auto) { array.pop_back(); });
+    }
+
+    Ref at(uint64_t index)
+    {
+        return std::apply([index](auto&... arrays) { return Ref { arrays[index]... }; }, _fields);
+    }
+
+    ConstRef at(uint64_t index) const
+    {
+        return std::apply([index](const auto&... arrays) { return ConstRef { arrays[index]... }; }, _fields);
+    }
+
+    // Packed array of one field, for field-wise loops
+    template<uint64_t I>
+    std::span<const Field<I>> field() const
+    {
+        return std::get<I>(_fields);
+    }
+
+    template<uint64_t I>
+    std::span<Field<I>> field()
+    {
+        return std::get<I>(_fields);
+    }
+
+ private:
+    template<typename F>
+    void forEachField(F&& f)
+    {
+        [&]<uint64_t... Is>(std::index_sequence<Is...>)
+        {
+            (f(std::get<Is>(_fields), std::get<Is>(FIELDS)), ...);
+        }(std::make_index_sequence<FIELD_COUNT>{});
+    }
+
+    template<typename Indices>
+    struct Arrays;
+
+    template<uint64_t... Is>
+    struct Arrays<std::index_sequence<Is...>>
+    {
+        using type = std::tuple<std::vector<Field<Is>, CacheLineAllocator<Field<Is>>>...>;
+    };
+
+    typename Arrays<std::make_index_sequence<FIELD_COUNT>>::type _fields;
+};
+
+template<typename T>
+using ComponentStorage = std::conditional_t<SoALayout<T>::value, SoAStorage<T>, AoSStorage<T>>;
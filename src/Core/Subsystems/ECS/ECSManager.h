@@ -3,6 +3,27 @@
 #include "./ComponentManager.h"
 #include "./EntityManager.h"
 #include "./SystemManager.h"
+#include "./CommandBuffer.h"
+#include "./View.h"
+#include "./Singleton.h"
+#include "./../Memory/MemoryTracker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Set of components to spawn entities from
+template<typename... Ts>
+struct Prefab
+{
+    std::tuple<Ts...> components;
+};
 
 class ECSManager
 {
@@ -10,51 +31,314 @@ class ECSManager
     // Create new entity and returns it
     Entity createEntity()
     {
+        MemoryScope scope(MemoryTag::ECS);
         return _entityManager->createEntity();
     }
 
+    // Create a batch of entities
+    std::vector<Entity> createEntities(uint64_t count)
+    {
+        MemoryScope scope(MemoryTag::ECS);
+        return _entityManager->createEntities(count);
+    }
+
     // Destroy entity and warns all the managers
     void destroyEntity(Entity entity)
     {
-        _entityManager->destroyEntity(entity);
+        MemoryScope scope(MemoryTag::ECS);
         _componentManager->entityDestroyed(entity);
         _systemManager->entityDestroyed(entity);
+        _entityManager->destroyEntity(entity);
+    }
+
+    // The entity is alive and the handle is not stale
+    bool isValid(Entity entity) const
+    {
+        return _entityManager->valid(entity);
     }
 
     template<typename T>
     void registerComponent()
     {
+        MemoryScope scope(MemoryTag::ECS);
         _componentManager->registerComponent<T>();
+
+        // Playback of the deferred commands on this component type
+        _addDeferred[componentType<T>]    = &ECSManager::addDeferred<T>;
+        _removeDeferred[componentType<T>] = &ECSManager::removeDeferred<T>;
     }
 
     // Add new component to an entity and warns all the managers
     template<typename T>
     void addComponent(Entity entity, T component)
     {
+        MemoryScope scope(MemoryTag::ECS);
         _componentManager->addComponent<T>(entity, component);
         auto signature = _entityManager->sig(entity);
-        signature.set(_componentManager->getComponentType<T>(), true);
+        signature.set(componentType<T>, true);
         _entityManager->sig(entity) = signature;
         _systemManager->entitySignatureChanged(entity, signature);
     }
 
+    // Add one component of each type to a batch of entities
+    // The signatures and the systems are updated once for the whole batch
+    template<typename... Ts>
+    void addComponents(std::span<const Entity> entities, std::span<const Ts>... components)
+    {
+        MemoryScope scope(MemoryTag::ECS);
+        assert(((components.size() == entities.size()) && ...) && "Entities and components count mismatch.");
+
+        (_componentManager->addComponents<Ts>(entities, components), ...);
+        componentsAdded(entities, signatureOf<Ts...>());
+    }
+
+    // Create entities from a prefab, each one gets a copy of its components
+    template<typename... Ts>
+    std::vector<Entity> spawn(const Prefab<Ts...>& prefab, uint64_t count)
+    {
+        MemoryScope scope(MemoryTag::ECS);
+        std::vector<Entity> entities = _entityManager->createEntities(count);
+
+        std::apply([&](const Ts&... components)
+        {
+            (_componentManager->addComponents<Ts>(entities, components), ...);
+        }, prefab.components);
+        componentsAdded(entities, signatureOf<Ts...>());
+
+        return entities;
+    }
+
     // Removes component to an entity and warns all the managers
     template<typename T>
     void removeComponent(Entity entity)
     {
+        MemoryScope scope(MemoryTag::ECS);
         _componentManager->removeComponent<T>(entity);
         auto signature = _entityManager->sig(entity);
-        signature.set(_componentManager->getComponentType<T>(), false);
+        signature.set(componentType<T>, false);
         _entityManager->sig(entity) = signature;
         _systemManager->entitySignatureChanged(entity, signature);
     }
 
     template<typename T>
-    T& getComponent(Entity entity)
+    ComponentRef<T> getComponent(Entity entity)
     {
+        assert(_entityManager->valid(entity) && "Invalid entity.");
         return _componentManager->getComponent<T>(entity);
     }
 
+    // Command buffer of the calling thread, for structural changes during updates
+    CommandBuffer& commands()
+    {
+        // Last buffer used by this thread, the ids are never reused so a destroyed manager never matches
+        thread_local uint64_t ownerId = 0;
+        thread_local CommandBuffer* buffer = nullptr;
+
+        if (ownerId != _id)
+        {
+            // First use on this thread or another manager used since, the buffers outlive the threads
+            MemoryScope scope(MemoryTag::ECS);
+            std::lock_guard lock(_commandBuffersMutex);
+            CommandBuffer*& threadBuffer = _threadCommandBuffers[std::this_thread::get_id()];
+            if (threadBuffer == nullptr)
+            {
+                threadBuffer = _commandBuffers.emplace_back(std::make_unique<CommandBuffer>()).get();
+            }
+            buffer = threadBuffer;
+            ownerId = _id;
+        }
+        return *buffer;
+    }
+
+    // Apply the commands of every thread, once per frame with no system running
+    // Created entities come first, then additions and removals batched by
+    // component type and sorted by entity, then destructions
+    // The commands on one component of one entity fold to their net effect,
+    // in recording order, so a removal then an addition replaces the component
+    void playback()
+    {
+        MemoryScope scope(MemoryTag::ECS);
+        // Create the pending entities of all the buffers at once
+        EntityIndex createdCount = 0;
+        for (const auto& buffer : _commandBuffers)
+        {
+            createdCount += buffer->_createdCount;
+        }
+        const std::vector<Entity> created = _entityManager->createEntities(createdCount);
+
+        _playbackCommands.clear();
+        EntityIndex createdOffset = 0;
+        for (const auto& buffer : _commandBuffers)
+        {
+            for (const auto& command : buffer->_commands)
+            {
+                Entity entity = command.entity;
+                if (CommandBuffer::isPending(entity))
+                {
+                    assert(entityIndex(entity) < buffer->_createdCount && "Placeholder entity used outside of its command buffer.");
+                    entity = created[createdOffset + entityIndex(entity)];
+                }
+                _playbackCommands.push_back({command.type, command.component, entity, buffer->_payload.data() + command.payload});
+            }
+            createdOffset += buffer->_createdCount;
+        }
+
+        // Stable so the commands on an entity keep their recording order
+        std::stable_sort(_playbackCommands.begin(), _playbackCommands.end(), [](const PlaybackCommand& a, const PlaybackCommand& b)
+        {
+            const bool aDestroys = a.type == CommandType::DestroyEntity;
+            const bool bDestroys = b.type == CommandType::DestroyEntity;
+            if (aDestroys != bDestroys)
+            {
+                return bDestroys;
+            }
+            if (a.component != b.component)
+            {
+                return a.component < b.component;
+            }
+            return a.entity < b.entity;
+        });
+
+        uint64_t first = 0;
+        while (first < _playbackCommands.size() && _playbackCommands[first].type != CommandType::DestroyEntity)
+        {
+            // Batch of the commands on the same component type
+            const ComponentType component = _playbackCommands[first].component;
+            _deferredRemovals.clear();
+            _deferredAdditions.clear();
+            while (first < _playbackCommands.size() && _playbackCommands[first].type != CommandType::DestroyEntity &&
+                   _playbackCommands[first].component == component)
+            {
+                first = foldEntityCommands(first);
+            }
+
+            if (!_deferredRemovals.empty())
+            {
+                (this->*_removeDeferred[component])(_deferredRemovals);
+            }
+            if (!_deferredAdditions.empty())
+            {
+                (this->*_addDeferred[component])(_deferredAdditions);
+            }
+        }
+
+        for (uint64_t i = first; i < _playbackCommands.size(); ++i)
+        {
+            // Skip entities destroyed more than once
+            if (i == first || _playbackCommands[i].entity != _playbackCommands[i - 1].entity)
+            {
+                destroyEntity(_playbackCommands[i].entity);
+            }
+        }
+
+        for (const auto& buffer : _commandBuffers)
+        {
+            buffer->clear();
+        }
+    }
+
+    // Read only access, the component is not marked as changed
+    template<typename T>
+    ComponentRef<const T> getComponent(Entity entity) const
+    {
+        assert(_entityManager->valid(entity) && "Invalid entity.");
+        return std::as_const(*_componentManager).getComponent<T>(entity);
+    }
+
+    // Entities having all the Ts and none of the excluded components
+    // The matching is cached and only redone when a storage changed structure
+    template<typename... Ts, typename... Es>
+    View<Exclude<Es...>, Ts...> view(Exclude<Es...> = {})
+    {
+        MemoryScope scope(MemoryTag::ECS);
+        using ViewType = View<Exclude<Es...>, Ts...>;
+        using Cache = typename ViewType::Cache;
+
+        const uint32_t type = viewType<Cache>;
+        if (type >= _viewCaches.size())
+        {
+            _viewCaches.resize(type + 1);
+        }
+        if (!_viewCaches[type])
+        {
+            _viewCaches[type] = std::make_unique<Cache>();
+        }
+
+        return ViewType
+        (
+            static_cast<Cache&>(*_viewCaches[type]),
+            { viewArray<Ts>()... },
+            { std::as_const(*_componentManager).getComponentArray<Es>()... }
+        );
+    }
+
+    // Create or replace the singleton of type T
+    template<typename T, typename... Args>
+    T& emplaceSingleton(Args&&... args)
+    {
+        MemoryScope scope(MemoryTag::ECS);
+        const uint32_t type = singletonType<T>;
+        if (type >= _singletons.size())
+        {
+            _singletons.resize(type + 1);
+        }
+        _singletons[type] = std::make_unique<Singleton<T>>(std::forward<Args>(args)...);
+        return static_cast<Singleton<T>&>(*_singletons[type]).value;
+    }
+
+    template<typename T>
+    bool hasSingleton() const
+    {
+        const uint32_t type = singletonType<T>;
+        return type < _singletons.size() && _singletons[type] != nullptr;
+    }
+
+    template<typename T>
+    T& singleton()
+    {
+        assert(hasSingleton<T>() && "Singleton used before created.");
+        return static_cast<Singleton<T>&>(*_singletons[singletonType<T>]).value;
+    }
+
+    template<typename T>
+    const T& singleton() const
+    {
+        assert(hasSingleton<T>() && "Singleton used before created.");
+        return static_cast<const Singleton<T>&>(*_singletons[singletonType<T>]).value;
+    }
+
+    // Packed storage of a component type
+    template<typename T>
+    const ComponentArray<T>& getComponentArray() const
+    {
+        return *std::as_const(*_componentManager).getComponentArray<T>();
+    }
+
+    // Mutable packed storage, for field-wise loops marking what they write
+    template<typename T>
+    ComponentArray<T>& getComponentArray()
+    {
+        return *_componentManager->getComponentArray<T>();
+    }
+
+    // The entity's component was mutably accessed after the given tick
+    template<typename T>
+    bool changedSince(Entity entity, uint64_t tick) const
+    {
+        return std::as_const(*_componentManager).getComponentArray<T>()->changedSince(entity, tick);
+    }
+
+    // Change tick stamped by the mutable accesses, advanced once per frame
+    uint64_t changeTick() const
+    {
+        return _componentManager->changeTick();
+    }
+
+    void advanceChangeTick()
+    {
+        _componentManager->advanceChangeTick();
+    }
+
     template<typename T>
     ComponentType getComponentType()
     {
@@ -64,16 +348,134 @@ class ECSManager
     template<typename T>
     std::shared_ptr<T> registerSystem()
     {
+        MemoryScope scope(MemoryTag::ECS);
         return _systemManager->registerSystem<T>();
     }
 
     template<typename T>
     void setSystemSignature(Signature signature)
     {
+        MemoryScope scope(MemoryTag::ECS);
         _systemManager->setSignature<T>(signature);
     }
 
+    // Set the signature of a system from its component list
+    template<typename T, typename... Components>
+    void setSystemSignature()
+    {
+        MemoryScope scope(MemoryTag::ECS);
+        _systemManager->setSignature<T>(signatureOf<Components...>());
+    }
+
  private:
+    template<typename T>
+    auto viewArray()
+    {
+        if constexpr (std::is_const_v<T>)
+        {
+            return std::as_const(*_componentManager).getComponentArray<std::remove_const_t<T>>();
+        }
+        else
+        {
+            return _componentManager->getComponentArray<T>();
+        }
+    }
+
+    struct PlaybackCommand
+    {
+        CommandType         type;
+        ComponentType       component;
+        Entity              entity;
+        const std::byte*    payload;
+    };
+
+    using DeferredBatch = void (ECSManager::*)(std::span<const PlaybackCommand>);
+
+    // Net effect of the additions and removals of one component on one entity,
+    // starting at first, returns the end of their run
+    // They alternate, the first tells if the entity had the component before
+    // and the last if it keeps it
+    uint64_t foldEntityCommands(uint64_t first)
+    {
+        const PlaybackCommand& front = _playbackCommands[first];
+        uint64_t last = first + 1;
+        while (last < _playbackCommands.size() &&
+               _playbackCommands[last].type != CommandType::DestroyEntity &&
+               _playbackCommands[last].component == front.component &&
+               _playbackCommands[last].entity == front.entity)
+        {
+            assert((_playbackCommands[last].type != CommandType::AddComponent || _playbackCommands[last - 1].type != CommandType::AddComponent) && "Component added to same entity more than once.");
+            assert((_playbackCommands[last].type != CommandType::RemoveComponent || _playbackCommands[last - 1].type != CommandType::RemoveComponent) && "Trying to remove non-existent component.");
+            ++last;
+        }
+
+        const PlaybackCommand& back = _playbackCommands[last - 1];
+        if (front.type == CommandType::RemoveComponent)
+        {
+            _deferredRemovals.push_back(front);
+        }
+        if (back.type == CommandType::AddComponent)
+        {
+            _deferredAdditions.push_back(back);
+        }
+        return last;
+    }
+
+    template<typename T>
+    void addDeferred(std::span<const PlaybackCommand> batch)
+    {
+        std::vector<Entity> entities(batch.size());
+        std::vector<T> components(batch.size());
+        for (uint64_t i = 0; i < batch.size(); ++i)
+        {
+            entities[i] = batch[i].entity;
+            std::memcpy(&components[i], batch[i].payload, sizeof(T));
+        }
+        addComponents<T>(entities, components);
+    }
+
+    template<typename T>
+    void removeDeferred(std::span<const PlaybackCommand> batch)
+    {
+        for (const auto& command : batch)
+        {
+            removeComponent<T>(command.entity);
+        }
+    }
+
+    // Merge the added components into the signatures of the batch
+    void componentsAdded(std::span<const Entity> entities, const Signature& added)
+    {
+        _signatureScratch.resize(entities.size());
+        for (uint64_t i = 0; i < entities.size(); ++i)
+        {
+            Signature& signature = _entityManager->sig(entities[i]);
+            signature |= added;
+            _signatureScratch[i] = signature;
+        }
+        _systemManager->entitiesComponentsAdded(entities, _signatureScratch);
+    }
+
+    std::vector<Signature> _signatureScratch;
+
+    // Thread command buffers and their playback
+    static inline std::atomic<uint64_t>         _nextId = 1;
+    const uint64_t                              _id = _nextId++;
+    std::vector<std::unique_ptr<CommandBuffer>> _commandBuffers;
+    std::unordered_map<std::thread::id, CommandBuffer*> _threadCommandBuffers;
+    std::mutex                                  _commandBuffersMutex;
+    std::vector<PlaybackCommand>                _playbackCommands;
+    std::vector<PlaybackCommand>                _deferredRemovals;
+    std::vector<PlaybackCommand>                _deferredAdditions;
+    std::array<DeferredBatch, MAX_COMPONENTS>   _addDeferred{};
+    std::array<DeferredBatch, MAX_COMPONENTS>   _removeDeferred{};
+
+    // Cached matching of the views, indexed by view type
+    std::vector<std::unique_ptr<IViewCache>>    _viewCaches;
+
+    // Singletons, indexed by singleton type
+    std::vector<std::unique_ptr<ISingleton>>    _singletons;
+
     std::unique_ptr<ComponentManager> _componentManager = std::make_unique<ComponentManager>();
     std::unique_ptr<EntityManager>    _entityManager    = std::make_unique<EntityManager>();
     std::unique_ptr<SystemManager>    _systemManager    = std::make_unique<SystemManager>();
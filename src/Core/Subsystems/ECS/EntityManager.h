@@ -2,66 +2,108 @@
 
 #include "./../../types.h"
 
-#include <queue>
-#include <array>
+#include <vector>
 #include <cassert>
 
 class EntityManager
 {
  public:
-     EntityManager()
+     // Create a new entity
+     Entity createEntity()
      {
-         // Fill the queue with all the possible entity IDs
-         for (Entity entity = 0; entity < MAX_ENTITIES; ++entity)
-         {
-            _availableEntities.push(entity);
-         }
+        // No free slot, grow the table
+        if (_freeHead == MAX_ENTITIES)
+        {
+            assert(_slots.size() < MAX_ENTITIES && "Reached entities limit.");
+
+            const EntityIndex index = static_cast<EntityIndex>(_slots.size());
+            _slots.push_back({});
+            return makeEntity(index, 0);
+        }
+
+        // Take a slot from the free list
+        const EntityIndex index = _freeHead;
+        Slot& slot = _slots[index];
+        _freeHead = slot.nextFree;
+        slot.nextFree = MAX_ENTITIES;
+
+        return makeEntity(index, slot.generation);
      }
 
-     // Create a new entity
-     Entity createEntity()
+     // Create a batch of entities, reusing the free slots first
+     std::vector<Entity> createEntities(uint64_t count)
      {
-        assert(_availableEntities.size() > 0 && "Reached entities limit.");
+        std::vector<Entity> entities;
+        entities.reserve(count);
 
-        // Take an ID from unused entities queue
-        Entity id = _availableEntities.front();
-        _availableEntities.pop();
+        while (count > 0 && _freeHead != MAX_ENTITIES)
+        {
+            entities.push_back(createEntity());
+            --count;
+        }
 
-        return id;
+        // Append the remaining slots at once
+        assert(_slots.size() + count <= MAX_ENTITIES && "Reached entities limit.");
+        const EntityIndex first = static_cast<EntityIndex>(_slots.size());
+        _slots.resize(_slots.size() + count);
+        for (EntityIndex index = first; index < _slots.size(); ++index)
+        {
+            entities.push_back(makeEntity(index, 0));
+        }
+
+        return entities;
      }
 
      // Destroy an entity
      void destroyEntity(Entity entity)
      {
-        assert(entity < MAX_ENTITIES && "Entity out of range.");
+        assert(valid(entity) && "Destroying an invalid entity.");
+
+        // Invalidate the handles and the signature of the slot
+        const EntityIndex index = entityIndex(entity);
+        Slot& slot = _slots[index];
+        slot.signature.reset();
+        ++slot.generation;
 
-        // Invalidate the destroyed entity's signature
-        _signatures[entity].reset();
+        // Put the slot back in the free list
+        slot.nextFree = _freeHead;
+        _freeHead = index;
+     }
 
-        // Put the destroyed entity's ID back to the unused entities queue
-        _availableEntities.push(entity);
+     // The entity is alive and the handle is not stale
+     bool valid(Entity entity) const
+     {
+        const EntityIndex index = entityIndex(entity);
+        return index < _slots.size() && _slots[index].generation == entityGeneration(entity);
      }
 
      // Set signature of an entity
      Signature& sig(Entity entity)
      {
-        assert(entity < MAX_ENTITIES && "Entity out of range.");
+        assert(valid(entity) && "Invalid entity.");
 
-        return _signatures[entity];
+        return _slots[entityIndex(entity)].signature;
      }
 
      // Get signature of an entity
      Signature sig(Entity entity) const
      {
-        assert(entity < MAX_ENTITIES && "Entity out of range.");
+        assert(valid(entity) && "Invalid entity.");
 
-        return _signatures[entity];
+        return _slots[entityIndex(entity)].signature;
      }
 
  private:
-     // Queue of unused entity IDs
-     std::queue<Entity> _availableEntities {};
+     struct Slot
+     {
+        Signature   signature   {};
+        uint32_t    generation  = 0;
+        EntityIndex nextFree    = MAX_ENTITIES; // Intrusive free list
+     };
+
+     // Slots where the index corresponds to the entity index
+     std::vector<Slot> _slots {};
 
-     // Array of signatures where the index corresponds to the entity ID
-     std::array<Signature, MAX_ENTITIES> _signatures {};
+     // First free slot, MAX_ENTITIES if none
+     EntityIndex _freeHead = MAX_ENTITIES;
 };
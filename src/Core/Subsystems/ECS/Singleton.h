@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+// Sequential singleton type IDs, indexing the singletons of the ECSManager
+class SingletonTypeCounter
+{
+ public:
+    static uint32_t next()
+    {
+        return _next++;
+    }
+
+ private:
+    static inline uint32_t _next = 0;
+};
+
+template<typename T>
+inline const uint32_t singletonType = SingletonTypeCounter::next();
+
+class ISingleton
+{
+ public:
+    virtual ~ISingleton() = default;
+};
+
+// Global state stored out of the component arrays, one instance per type
+template<typename T>
+class Singleton : public ISingleton
+{
+ public:
+    template<typename... Args>
+    explicit Singleton(Args&&... args) : value(std::forward<Args>(args)...) {}
+
+    T value;
+};
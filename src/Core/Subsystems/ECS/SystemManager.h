@@ -4,6 +4,9 @@
 #include "./../../types.h"
 
 #include <memory>
+#include <span>
+#include <vector>
+#include <algorithm>
 #include <unordered_map>
 #include <cassert>
 
@@ -70,6 +73,37 @@ class SystemManager
         }
     }
 
+    // Notify each system that a batch of entities gained components
+    // A signature only grows here so entities can join systems but never leave
+    void entitiesComponentsAdded(std::span<const Entity> entities, std::span<const Signature> entitySignatures)
+    {
+        std::vector<Entity> matching;
+        matching.reserve(entities.size());
+
+        for (const auto& pair : _systems)
+        {
+            const auto& type = pair.first;
+            const auto& system = pair.second;
+            const auto& systemSignature = _signatures[type];
+
+            matching.clear();
+            for (uint64_t i = 0; i < entities.size(); ++i)
+            {
+                if ((entitySignatures[i] & systemSignature) == systemSignature)
+                {
+                    matching.push_back(entities[i]);
+                }
+            }
+
+            // Sorted so the set appends at its end with a hint
+            std::sort(matching.begin(), matching.end());
+            for (const auto entity : matching)
+            {
+                system->_entities.insert(system->_entities.end(), entity);
+            }
+        }
+    }
+
  private:
      // Map from system type string pointer to a signature
      std::unordered_map<const char*, Signature> _signatures{};
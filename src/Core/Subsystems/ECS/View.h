@@ -0,0 +1,259 @@
+#pragma once
+
+#include "./../../types.h"
+#include "./ComponentArray.h"
+#include "./../Jobs/ThreadPool.h"
+#include "./../Memory/FrameArena.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <memory>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Components an entity must not have to be part of a view
+template<typename... Ts>
+struct Exclude {};
+
+template<typename... Ts>
+inline constexpr Exclude<Ts...> exclude {};
+
+// Sequential view type IDs, indexing the view caches of the ECSManager
+class ViewTypeCounter
+{
+ public:
+    static uint32_t next()
+    {
+        return _next++;
+    }
+
+ private:
+    static inline uint32_t _next = 0;
+};
+
+template<typename T>
+inline const uint32_t viewType = ViewTypeCounter::next();
+
+class IViewCache
+{
+ public:
+    virtual ~IViewCache() = default;
+};
+
+// Matching entities of a view and the dense indices of their components
+// Kept across frames and rebuilt when one of the storages changed structure
+template<typename Excluded, typename... Ts>
+class ViewCache;
+
+template<typename... Es, typename... Ts>
+class ViewCache<Exclude<Es...>, Ts...> : public IViewCache
+{
+ public:
+    static constexpr uint64_t COUNT = sizeof...(Ts);
+    using Row = std::array<uint32_t, COUNT>;
+
+    template<typename Arrays, typename ExcludedArrays>
+    void update(const Arrays& arrays, const ExcludedArrays& excluded)
+    {
+        const auto versions = std::apply([](const auto*... array)
+        {
+            return std::array<uint64_t, COUNT + sizeof...(Es)> { array->structureVersion()... };
+        }, std::tuple_cat(arrays, excluded));
+
+        if (_valid && versions == _versions)
+        {
+            return;
+        }
+        _versions = versions;
+        _valid = true;
+
+        // Drive the matching with the smallest storage
+        const std::array<uint64_t, COUNT> sizes = std::apply([](const auto*... array)
+        {
+            return std::array<uint64_t, COUNT> { array->size()... };
+        }, arrays);
+        const uint64_t smallest = std::min_element(sizes.begin(), sizes.end()) - sizes.begin();
+
+        std::span<const Entity> candidates;
+        forEachIndex([&](auto i)
+        {
+            if (i == smallest)
+            {
+                candidates = std::get<i>(arrays)->entities();
+            }
+        });
+
+        _entities.clear();
+        _rows.clear();
+        for (const auto entity : candidates)
+        {
+            const bool isExcluded = std::apply([entity](const auto*... array)
+            {
+                return (array->contains(entity) || ...);
+            }, excluded);
+            if (isExcluded)
+            {
+                continue;
+            }
+
+            Row row;
+            bool matches = true;
+            forEachIndex([&](auto i)
+            {
+                row[i] = std::get<i>(arrays)->find(entity);
+                matches &= row[i] != std::numeric_limits<uint32_t>::max();
+            });
+            if (matches)
+            {
+                _entities.push_back(entity);
+                _rows.push_back(row);
+            }
+        }
+    }
+
+    std::vector<Entity> _entities;
+    std::vector<Row>    _rows;
+
+ private:
+    template<typename F>
+    static void forEachIndex(F&& f)
+    {
+        [&]<uint64_t... Is>(std::index_sequence<Is...>)
+        {
+            (f(std::integral_constant<uint64_t, Is>{}), ...);
+        }(std::make_index_sequence<COUNT>{});
+    }
+
+    std::array<uint64_t, COUNT + sizeof...(Es)> _versions {};
+    bool _valid = false;
+};
+
+// Typed iteration over the entities having all the Ts and none of the excluded
+// Access through a const T does not mark the components as changed
+template<typename Excluded, typename... Ts>
+class View;
+
+template<typename... Es, typename... Ts>
+class View<Exclude<Es...>, Ts...>
+{
+ public:
+    using Cache = ViewCache<Exclude<Es...>, std::remove_const_t<Ts>...>;
+
+    // Entities per parallel chunk, large enough that the cache lines shared by two
+    // chunks at their edges are few. The rows reach the dense arrays through their
+    // indices, so the chunks are not aligned on the lines of any array
+    static constexpr uint64_t CHUNK_SIZE = 4096;
+
+    template<typename T>
+    using ArrayPointer = std::conditional_t<std::is_const_v<T>, const ComponentArray<std::remove_const_t<T>>*, ComponentArray<T>*>;
+
+    View(Cache& cache, std::tuple<ArrayPointer<Ts>...> arrays, std::tuple<const ComponentArray<Es>*...> excluded)
+        : _cache(cache), _arrays(arrays)
+    {
+        _cache.update(_arrays, excluded);
+    }
+
+    // Calls f(Ts&...) or f(Entity, Ts&...) on each entity, in storage order
+    // SoA components are given as their proxies, taken by value or auto&&
+    template<typename F>
+    void each(F&& f)
+    {
+        eachRange(0, size(), f);
+    }
+
+    // Same as each() over the matching entities [first, last)
+    template<typename F>
+    void eachRange(uint64_t first, uint64_t last, F& f)
+    {
+        for (uint64_t i = first; i < last; ++i)
+        {
+            call(i, f, std::index_sequence_for<Ts...>{});
+        }
+    }
+
+    // Calls f on the entities from the threads of the pool
+    // f must only touch the components it is given
+    template<typename F>
+    void par_each(F&& f)
+    {
+        const uint64_t count = size();
+        auto chunkJob = [&](uint64_t chunk)
+        {
+            eachRange(chunk * CHUNK_SIZE, std::min((chunk + 1) * CHUNK_SIZE, count), f);
+        };
+        ThreadPool::shared().parallelFor((count + CHUNK_SIZE - 1) / CHUNK_SIZE, chunkJob);
+    }
+
+    // Parallel reduction of f(Ts&...) or f(Entity, Ts&...) with combine
+    // The chunks do not depend on the thread count and their partial results
+    // are combined in storage order, so the result is the same on every run
+    template<typename R, typename F, typename C>
+    R par_reduce(R init, F&& f, C&& combine)
+    {
+        const uint64_t count = size();
+        FrameVector<R> partials(&FrameArena::local());
+        partials.assign((count + CHUNK_SIZE - 1) / CHUNK_SIZE, init);
+
+        auto chunkJob = [&](uint64_t chunk)
+        {
+            R& partial = partials[chunk];
+            auto accumulate = [&](Entity entity, ComponentRef<Ts>... components)
+            {
+                if constexpr (std::is_invocable_v<F&, Entity, ComponentRef<Ts>...>)
+                {
+                    partial = combine(partial, f(entity, components...));
+                }
+                else
+                {
+                    partial = combine(partial, f(components...));
+                }
+            };
+            eachRange(chunk * CHUNK_SIZE, std::min((chunk + 1) * CHUNK_SIZE, count), accumulate);
+        };
+        ThreadPool::shared().parallelFor(partials.size(), chunkJob);
+
+        R result = init;
+        for (const auto& partial : partials)
+        {
+            result = combine(result, partial);
+        }
+        return result;
+    }
+
+    uint64_t size() const
+    {
+        return _cache._rows.size();
+    }
+
+    bool empty() const
+    {
+        return _cache._rows.empty();
+    }
+
+    std::span<const Entity> entities() const
+    {
+        return _cache._entities;
+    }
+
+ private:
+    template<typename F, uint64_t... Is>
+    void call(uint64_t i, F& f, std::index_sequence<Is...>)
+    {
+        const auto& row = _cache._rows[i];
+        if constexpr (std::is_invocable_v<F&, Entity, ComponentRef<Ts>...>)
+        {
+            f(_cache._entities[i], std::get<Is>(_arrays)->at(row[Is])...);
+        }
+        else
+        {
+            f(std::get<Is>(_arrays)->at(row[Is])...);
+        }
+    }
+
+    Cache& _cache;
+    std::tuple<ArrayPointer<Ts>...> _arrays;
+};
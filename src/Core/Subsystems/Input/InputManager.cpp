@@ -4,6 +4,8 @@ std::map<InputKey, bool> InputManager::_keysStatus;
 bool InputManager::_focused = false;
 glm::vec2 InputManager::_lastMousePos;
 glm::vec2 InputManager::mouseOffset;
+std::vector<InputEvent> InputManager::_pendingEvents;
+InputRecording InputManager::_recording;
 
 static inline InputKey toGLFWType(const int key)
 {
@@ -28,15 +30,19 @@ static inline InputKey toGLFWType(const int key)
 
 void InputManager::keyCallback(GLFWwindow* window, int key, int scancode, int action, int mobs)
 {
+    // Applied at the start of the next step, replaced by the recording when replaying
     InputKey realKey = toGLFWType(key);
-    switch(action)
+    if (realKey != UNDEFINED && !_recording.replaying())
     {
-        case GLFW_PRESS:
-            _keysStatus[realKey] = true;
-            break;
-        case GLFW_RELEASE:
-            _keysStatus[realKey] = false;
-            break;
+        switch(action)
+        {
+            case GLFW_PRESS:
+                _pendingEvents.push_back({0.0f, InputEventType::KeyDown, static_cast<uint8_t>(realKey)});
+                break;
+            case GLFW_RELEASE:
+                _pendingEvents.push_back({0.0f, InputEventType::KeyUp, static_cast<uint8_t>(realKey)});
+                break;
+        }
     }
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
     {
@@ -70,10 +76,9 @@ bool InputManager::keyIsDown(const InputKey key)
 
 void InputManager::cursorPositionCallback(GLFWwindow* window, double xpos, double ypos)
 {
-    if (_focused)
+    if (_focused && !_recording.replaying())
     {
-        mouseOffset.x = xpos-_lastMousePos.x;
-        mouseOffset.y = ypos-_lastMousePos.y;
+        _pendingEvents.push_back({0.0f, InputEventType::MouseMove, 0, static_cast<float>(xpos - _lastMousePos.x), static_cast<float>(ypos - _lastMousePos.y)});
     }
     _lastMousePos.x = xpos;
     _lastMousePos.y = ypos;
@@ -84,3 +89,82 @@ void InputManager::resetMouseMovements()
     mouseOffset.x = 0.0f;
     mouseOffset.y = 0.0f;
 }
+
+void InputManager::beginStep(const float time)
+{
+    InputEvent event;
+    if (_recording.replaying())
+    {
+        while (_recording.next(time, event))
+        {
+            applyEvent(event);
+        }
+        return;
+    }
+
+    for (auto& pendingEvent : _pendingEvents)
+    {
+        pendingEvent.time = time;
+        applyEvent(pendingEvent);
+        if (_recording.recording())
+        {
+            _recording.write(pendingEvent);
+        }
+    }
+    _pendingEvents.clear();
+}
+
+void InputManager::applyEvent(const InputEvent& event)
+{
+    switch (event.type)
+    {
+        case InputEventType::KeyDown:
+            _keysStatus[static_cast<InputKey>(event.key)] = true;
+            break;
+        case InputEventType::KeyUp:
+            _keysStatus[static_cast<InputKey>(event.key)] = false;
+            break;
+        case InputEventType::MouseMove:
+            // Moves of the frame add up until the camera consumes them
+            mouseOffset.x += event.x;
+            mouseOffset.y += event.y;
+            break;
+        case InputEventType::End:
+            break;
+    }
+}
+
+bool InputManager::startRecording(const std::string& path, const uint32_t seed)
+{
+    return _recording.record(path, seed);
+}
+
+// The end marker keeps the length of the session
+void InputManager::stopRecording(const float time)
+{
+    if (_recording.recording())
+    {
+        _recording.write({time, InputEventType::End});
+        _recording.close();
+    }
+}
+
+bool InputManager::startReplay(const std::string& path)
+{
+    return _recording.replay(path);
+}
+
+bool InputManager::replaying()
+{
+    return _recording.replaying();
+}
+
+bool InputManager::replayFinished()
+{
+    return _recording.replaying() && _recording.finished();
+}
+
+uint32_t InputManager::sessionSeed()
+{
+    return _recording.seed();
+}
@@ -1,10 +1,12 @@
 #pragma once
 
 #include "./../../utils.h"
+#include "./InputRecording.h"
 
 #include <GLFW/glfw3.h>
 #include <map>
 #include <iostream>
+#include <vector>
 #include <glm/glm.hpp>
 
 enum InputKey
@@ -18,6 +20,9 @@ enum InputKey
     KEY_LEFT_CONTROL,
 };
 
+// Keys and mouse state, changed by events applied once per simulation step
+// The GLFW callbacks queue the events, which can be recorded, or replaced by
+// the events of a recording so a session replays identically
 class InputManager
 {
  public:
@@ -26,9 +31,26 @@ class InputManager
     static void cursorPositionCallback(GLFWwindow* window, double xpos, double ypos);
     static void resetMouseMovements();
     static glm::vec2 mouseOffset;
-    
+
+    // Apply the events of the step starting at the simulation time
+    static void beginStep(const float time);
+
+    static bool startRecording(const std::string& path, const uint32_t seed);
+    static void stopRecording(const float time);
+    static bool startReplay(const std::string& path);
+    static bool replaying();
+    static bool replayFinished();
+
+    // Seed of the recorded or replayed session
+    static uint32_t sessionSeed();
+
  private:
+    static void applyEvent(const InputEvent& event);
+
     static std::map<InputKey, bool> _keysStatus;
     static bool _focused;
     static glm::vec2 _lastMousePos;
+
+    static std::vector<InputEvent>  _pendingEvents;
+    static InputRecording           _recording;
 };
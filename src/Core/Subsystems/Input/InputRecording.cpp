@@ -0,0 +1,128 @@
+#include "./InputRecording.h"
+
+#include "./../../utils.h"
+
+// Fixed size fields, the engine only targets little endian hosts
+template<typename T>
+static void writeField(std::ofstream& stream, const T& value)
+{
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+static bool readField(std::ifstream& stream, T& value)
+{
+    return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+InputRecording::~InputRecording()
+{
+    close();
+}
+
+bool InputRecording::record(const std::string& path, const uint32_t seed)
+{
+    close();
+
+    _output.open(path, std::ios::binary | std::ios::trunc);
+    if (!_output.is_open())
+    {
+        ERROR("Failed to open input recording " << path << '.');
+        return false;
+    }
+
+    _seed = seed;
+    writeField(_output, MAGIC);
+    writeField(_output, VERSION);
+    writeField(_output, _seed);
+    return true;
+}
+
+bool InputRecording::replay(const std::string& path)
+{
+    close();
+
+    std::ifstream input(path, std::ios::binary);
+    if (!input.is_open())
+    {
+        ERROR("Failed to open input recording " << path << '.');
+        return false;
+    }
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    if (!readField(input, magic) || !readField(input, version) || !readField(input, _seed) || magic != MAGIC || version != VERSION)
+    {
+        ERROR(path << " is not an input recording of this version.");
+        return false;
+    }
+
+    InputEvent event;
+    while (readField(input, event.time) && readField(input, event.type) && readField(input, event.key))
+    {
+        if (event.type == InputEventType::MouseMove && !(readField(input, event.x) && readField(input, event.y)))
+        {
+            break;
+        }
+        _events.push_back(event);
+        event = InputEvent{};
+    }
+
+    _nextEvent = 0;
+    _replaying = true;
+    INFO("Replaying " << _events.size() << " input events from " << path);
+    return true;
+}
+
+void InputRecording::close()
+{
+    if (_output.is_open())
+    {
+        _output.close();
+    }
+    _events.clear();
+    _nextEvent = 0;
+    _replaying = false;
+}
+
+bool InputRecording::recording() const
+{
+    return _output.is_open();
+}
+
+bool InputRecording::replaying() const
+{
+    return _replaying;
+}
+
+uint32_t InputRecording::seed() const
+{
+    return _seed;
+}
+
+void InputRecording::write(const InputEvent& event)
+{
+    writeField(_output, event.time);
+    writeField(_output, event.type);
+    writeField(_output, event.key);
+    if (event.type == InputEventType::MouseMove)
+    {
+        writeField(_output, event.x);
+        writeField(_output, event.y);
+    }
+}
+
+bool InputRecording::next(const float time, InputEvent& event)
+{
+    if (_nextEvent >= _events.size() || _events[_nextEvent].time > time)
+    {
+        return false;
+    }
+    event = _events[_nextEvent++];
+    return true;
+}
+
+bool InputRecording::finished() const
+{
+    return _nextEvent >= _events.size();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+enum class InputEventType : uint8_t
+{
+    KeyDown,
+    KeyUp,
+    MouseMove,  // Cursor offset since the previous event
+    End,        // End of the session, written last
+};
+
+// Input applied at a simulation time, in seconds
+struct InputEvent
+{
+    float           time;
+    InputEventType  type;
+    uint8_t         key     = 0;    // InputKey of the key events
+    float           x       = 0.0f; // Offset of the mouse moves
+    float           y       = 0.0f;
+};
+
+// Binary file of timestamped input events
+// Header: magic, version and the seed of the session random generation
+// Events: time, type, key and for mouse moves their offset, little endian
+class InputRecording
+{
+ public:
+    ~InputRecording();
+
+    bool record(const std::string& path, const uint32_t seed);
+    bool replay(const std::string& path);
+    void close();
+
+    bool recording() const;
+    bool replaying() const;
+
+    // Seed of the recorded session
+    uint32_t seed() const;
+
+    void write(const InputEvent& event);
+
+    // Next replayed event applied at or before the time, false if none
+    bool next(const float time, InputEvent& event);
+
+    // Every replayed event was read
+    bool finished() const;
+
+ private:
+    static constexpr uint32_t MAGIC     = 0x52494243; // "CBIR"
+    static constexpr uint32_t VERSION   = 1;
+
+    std::ofstream           _output;
+    std::vector<InputEvent> _events;
+    uint64_t                _nextEvent = 0;
+    uint32_t                _seed = 0;
+    bool                    _replaying = false;
+};
@@ -0,0 +1,128 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace
+{
+    // Set on the threads running a chunk
+    thread_local bool t_insideJob = false;
+
+    // A quarter of the hardware threads draw on the render pool
+    uint32_t renderWorkerCount()
+    {
+        return std::thread::hardware_concurrency() / 4;
+    }
+}
+
+ThreadPool::ThreadPool(const uint32_t workerCount)
+{
+    _workers.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; ++i)
+    {
+        _workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(_mutex);
+        _stop = true;
+    }
+    _wake.notify_all();
+
+    for (auto& worker : _workers)
+    {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared()
+{
+    static ThreadPool pool(std::max(std::thread::hardware_concurrency(), 1u) - 1 - renderWorkerCount());
+    return pool;
+}
+
+ThreadPool& ThreadPool::render()
+{
+    static ThreadPool pool(renderWorkerCount());
+    return pool;
+}
+
+uint32_t ThreadPool::threadCount() const
+{
+    return static_cast<uint32_t>(_workers.size()) + 1;
+}
+
+void ThreadPool::parallelFor(const uint64_t chunkCount, const std::function<void(uint64_t)>& f)
+{
+    if (chunkCount == 0)
+    {
+        return;
+    }
+
+    // Not worth waking the workers
+    if (_workers.empty() || chunkCount == 1 || t_insideJob)
+    {
+        for (uint64_t chunk = 0; chunk < chunkCount; ++chunk)
+        {
+            f(chunk);
+        }
+        return;
+    }
+
+    std::lock_guard submit(_submitMutex);
+    {
+        std::lock_guard lock(_mutex);
+        _job = &f;
+        _chunkCount = chunkCount;
+        _nextChunk = 0;
+        ++_jobGeneration;
+    }
+    _wake.notify_all();
+
+    runChunks(f);
+
+    // Wait for the workers still running a chunk
+    std::unique_lock lock(_mutex);
+    _done.wait(lock, [this]() { return _activeWorkers == 0; });
+    _job = nullptr;
+}
+
+void ThreadPool::runChunks(const std::function<void(uint64_t)>& f)
+{
+    t_insideJob = true;
+    for (uint64_t chunk = _nextChunk++; chunk < _chunkCount; chunk = _nextChunk++)
+    {
+        f(chunk);
+    }
+    t_insideJob = false;
+}
+
+void ThreadPool::workerLoop()
+{
+    uint64_t seenGeneration = 0;
+
+    std::unique_lock lock(_mutex);
+    while (true)
+    {
+        _wake.wait(lock, [&]() { return _stop || (_job != nullptr && _jobGeneration != seenGeneration); });
+        if (_stop)
+        {
+            return;
+        }
+
+        seenGeneration = _jobGeneration;
+        const auto* job = _job;
+        ++_activeWorkers;
+        lock.unlock();
+
+        runChunks(*job);
+
+        lock.lock();
+        if (--_activeWorkers == 0)
+        {
+            _done.notify_one();
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running the chunks of a parallel loop
+// The calling thread takes part in the work and returns once every chunk is done
+class ThreadPool
+{
+ public:
+    explicit ThreadPool(uint32_t workerCount);
+    ~ThreadPool();
+
+    // Pool of the simulation, one worker per hardware thread besides the caller
+    // and the workers of the render pool
+    static ThreadPool& shared();
+
+    // Pool of the render thread, kept apart so its loops do not wait for
+    // the simulation ones to release the pool
+    static ThreadPool& render();
+
+    // Run f(chunk) for every chunk in [0, chunkCount)
+    // Nested calls from inside a chunk run serially on the calling thread
+    void parallelFor(uint64_t chunkCount, const std::function<void(uint64_t)>& f);
+
+    // Same with f taken by reference, the std::function then only holds
+    // that reference and fits its small buffer, no heap allocation per loop
+    template<typename F>
+    void parallelFor(uint64_t chunkCount, F& f)
+    {
+        parallelFor(chunkCount, std::function<void(uint64_t)>([&f](uint64_t chunk) { f(chunk); }));
+    }
+
+    // Threads working on a loop, the caller included
+    uint32_t threadCount() const;
+
+ private:
+    void workerLoop();
+    void runChunks(const std::function<void(uint64_t)>& f);
+
+    std::vector<std::thread>    _workers;
+
+    std::mutex                  _submitMutex;   // One loop at a time
+    std::mutex                  _mutex;
+    std::condition_variable     _wake;
+    std::condition_variable     _done;
+
+    const std::function<void(uint64_t)>* _job = nullptr;
+    uint64_t                    _jobGeneration = 0;
+    uint64_t                    _chunkCount = 0;
+    std::atomic<uint64_t>       _nextChunk = 0;
+    uint32_t                    _activeWorkers = 0;
+    bool                        _stop = false;
+};
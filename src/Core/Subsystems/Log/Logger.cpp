@@ -0,0 +1,345 @@
+#include "Logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// Single producer single consumer ring of size prefixed records
+class LogRing
+{
+ public:
+    bool push(const std::byte* data, const uint32_t size)
+    {
+        const uint64_t head = _head.load(std::memory_order_relaxed);
+        const uint64_t tail = _tail.load(std::memory_order_acquire);
+        if (head - tail + sizeof(size) + size > CAPACITY)
+        {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        copyIn(head, &size, sizeof(size));
+        copyIn(head + sizeof(size), data, size);
+        _head.store(head + sizeof(size) + size, std::memory_order_release);
+        return true;
+    }
+
+    // Size of the record copied to data, 0 when empty
+    uint32_t pop(std::byte* data)
+    {
+        const uint64_t tail = _tail.load(std::memory_order_relaxed);
+        const uint64_t head = _head.load(std::memory_order_acquire);
+        if (head == tail)
+        {
+            return 0;
+        }
+
+        uint32_t size = 0;
+        copyOut(tail, &size, sizeof(size));
+        copyOut(tail + sizeof(size), data, size);
+        _tail.store(tail + sizeof(size) + size, std::memory_order_release);
+        return size;
+    }
+
+    // Records dropped since the previous call, consumer side
+    uint64_t takeDropped()
+    {
+        const uint64_t dropped = _dropped.load(std::memory_order_relaxed);
+        const uint64_t count = dropped - _reportedDropped;
+        _reportedDropped = dropped;
+        return count;
+    }
+
+    // The thread exited, freed once drained
+    std::atomic<bool> retired = false;
+
+ private:
+    void copyIn(const uint64_t position, const void* data, const uint64_t size)
+    {
+        const uint64_t offset = position % CAPACITY;
+        const uint64_t first = std::min(size, CAPACITY - offset);
+        std::memcpy(&_data[offset], data, first);
+        std::memcpy(&_data[0], static_cast<const std::byte*>(data) + first, size - first);
+    }
+
+    void copyOut(const uint64_t position, void* data, const uint64_t size) const
+    {
+        const uint64_t offset = position % CAPACITY;
+        const uint64_t first = std::min(size, CAPACITY - offset);
+        std::memcpy(data, &_data[offset], first);
+        std::memcpy(static_cast<std::byte*>(data) + first, &_data[0], size - first);
+    }
+
+    static const uint64_t CAPACITY = 1 << 16;
+
+    // Bytes written and read, on their own cache lines
+    alignas(64) std::atomic<uint64_t>   _head = 0;
+    alignas(64) std::atomic<uint64_t>   _tail = 0;
+
+    std::atomic<uint64_t>               _dropped = 0;
+    uint64_t                            _reportedDropped = 0;
+
+    std::array<std::byte, CAPACITY>     _data;
+};
+
+namespace
+{
+    // Retires the ring of the thread when it exits
+    struct ThreadRing
+    {
+        LogRing* ring = nullptr;
+
+        ~ThreadRing()
+        {
+            if (ring != nullptr)
+            {
+                ring->retired.store(true, std::memory_order_release);
+                ring = nullptr;
+            }
+        }
+    };
+
+    thread_local ThreadRing t_ring;
+
+    const char* levelPrefix(const LogLevel level)
+    {
+        switch (level)
+        {
+            case LogLevel::Info:    return "   \033[44m\033[1m[INFO]\033[49m\033[0m ";
+            case LogLevel::Ok:      return "   \033[42m\033[1m[ OK ]\033[49m\033[0m ";
+            case LogLevel::Warning: return "\033[43m\033[1m[WARNING]\033[49m\033[0m ";
+            case LogLevel::Error:   return "  \033[41m\033[1m[ERROR]\033[49m\033[0m ";
+        }
+        return "";
+    }
+}
+
+LogRecord::LogRecord(const LogLevel level)
+{
+    _data[0] = static_cast<std::byte>(level);
+    _size = 1;
+}
+
+LogRecord::~LogRecord()
+{
+    Logger::instance().push(_data.data(), _size);
+}
+
+LogRecord& LogRecord::operator<<(const char* text)
+{
+    return *this << std::string_view(text);
+}
+
+LogRecord& LogRecord::operator<<(const std::string& text)
+{
+    return *this << std::string_view(text);
+}
+
+LogRecord& LogRecord::operator<<(const std::string_view text)
+{
+    const uint32_t header = sizeof(LogArg) + sizeof(uint32_t);
+    if (_size + header > MAX_SIZE)
+    {
+        return *this;
+    }
+
+    const uint32_t length = static_cast<uint32_t>(std::min<uint64_t>(text.size(), MAX_SIZE - _size - header));
+    _data[_size] = static_cast<std::byte>(LogArg::String);
+    std::memcpy(&_data[_size + sizeof(LogArg)], &length, sizeof(length));
+    std::memcpy(&_data[_size + header], text.data(), length);
+    _size += header + length;
+    return *this;
+}
+
+LogRecord& LogRecord::operator<<(const char c)
+{
+    append(LogArg::Char, &c, sizeof(c));
+    return *this;
+}
+
+LogRecord& LogRecord::operator<<(const bool b)
+{
+    append(LogArg::Bool, &b, sizeof(b));
+    return *this;
+}
+
+void LogRecord::append(const LogArg type, const void* data, const uint32_t size)
+{
+    if (_size + sizeof(LogArg) + size > MAX_SIZE)
+    {
+        return;
+    }
+    _data[_size] = static_cast<std::byte>(type);
+    std::memcpy(&_data[_size + sizeof(LogArg)], data, size);
+    _size += sizeof(LogArg) + size;
+}
+
+// Never destroyed, the threads may log until the process exits
+Logger& Logger::instance()
+{
+    static Logger* const logger = []()
+    {
+        Logger* const created = new Logger();
+        std::atexit(&Logger::shutdown);
+        return created;
+    }();
+    return *logger;
+}
+
+Logger::Logger()
+{
+    _writer = std::thread(&Logger::writerLoop, this);
+}
+
+// Stop the writer at exit, the remaining records are written by the exiting thread
+void Logger::shutdown()
+{
+    Logger& logger = instance();
+    logger._stop.store(true, std::memory_order_release);
+    if (logger._writer.joinable())
+    {
+        logger._writer.join();
+    }
+    logger.flush();
+}
+
+bool Logger::push(const std::byte* data, const uint32_t size)
+{
+    return threadRing().push(data, size);
+}
+
+void Logger::flush()
+{
+    drain();
+    std::cerr.flush();
+}
+
+LogRing& Logger::threadRing()
+{
+    if (t_ring.ring == nullptr)
+    {
+        LogRing* const ring = new LogRing();
+        std::lock_guard lock(_ringsMutex);
+        _rings.push_back(ring);
+        t_ring.ring = ring;
+    }
+    return *t_ring.ring;
+}
+
+void Logger::writerLoop()
+{
+    while (!_stop.load(std::memory_order_acquire))
+    {
+        if (!drain())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+// Write the queued records of every ring, true if any was
+bool Logger::drain()
+{
+    std::lock_guard writeLock(_writeMutex);
+
+    // Copied into a kept vector, the writer does not allocate once warm
+    {
+        std::lock_guard lock(_ringsMutex);
+        _drainedRings.assign(_rings.begin(), _rings.end());
+    }
+
+    bool written = false;
+    std::array<std::byte, LogRecord::MAX_SIZE> record;
+    for (auto* ring : _drainedRings)
+    {
+        // Read before draining, the thread does not log once retired
+        const bool retired = ring->retired.load(std::memory_order_acquire);
+
+        while (const uint32_t size = ring->pop(record.data()))
+        {
+            write(record.data(), size);
+            written = true;
+        }
+
+        if (const uint64_t dropped = ring->takeDropped())
+        {
+            std::cerr << levelPrefix(LogLevel::Warning) << dropped << " log records dropped, the ring of their thread was full\n";
+        }
+
+        if (retired)
+        {
+            std::lock_guard lock(_ringsMutex);
+            std::erase(_rings, ring);
+            delete ring;
+        }
+    }
+    return written;
+}
+
+// Format a record, the arguments are streamed in their encoded order
+void Logger::write(const std::byte* data, const uint32_t size) const
+{
+    std::cerr << levelPrefix(static_cast<LogLevel>(data[0]));
+
+    uint32_t offset = 1;
+    const auto read = [&data, &offset](auto& value)
+    {
+        std::memcpy(&value, &data[offset], sizeof(value));
+        offset += sizeof(value);
+    };
+
+    while (offset < size)
+    {
+        LogArg type;
+        read(type);
+        switch (type)
+        {
+            case LogArg::Int:
+            {
+                int64_t value;
+                read(value);
+                std::cerr << value;
+                break;
+            }
+            case LogArg::UInt:
+            {
+                uint64_t value;
+                read(value);
+                std::cerr << value;
+                break;
+            }
+            case LogArg::Double:
+            {
+                double value;
+                read(value);
+                std::cerr << value;
+                break;
+            }
+            case LogArg::Char:
+            {
+                char value;
+                read(value);
+                std::cerr << value;
+                break;
+            }
+            case LogArg::Bool:
+            {
+                bool value;
+                read(value);
+                std::cerr << value;
+                break;
+            }
+            case LogArg::String:
+            {
+                uint32_t length;
+                read(length);
+                std::cerr.write(reinterpret_cast<const char*>(&data[offset]), length);
+                offset += length;
+                break;
+            }
+        }
+    }
+    std::cerr << '\n';
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Records below this level are compiled out, e.g. -DLOG_MIN_LEVEL=2 keeps warnings and errors
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0
+#endif
+
+enum class LogLevel : uint8_t
+{
+    Info,
+    Ok,
+    Warning,
+    Error,
+};
+
+// Type tags of the encoded arguments
+enum class LogArg : uint8_t
+{
+    Int,
+    UInt,
+    Double,
+    Char,
+    Bool,
+    String,     // Length then the characters
+};
+
+// Record encoded on the stack by the streamed arguments, queued when destroyed
+// Formatting is left to the writer thread, strings are copied and truncated to fit
+class LogRecord
+{
+ public:
+    explicit LogRecord(const LogLevel level);
+    ~LogRecord();
+
+    LogRecord(const LogRecord&) = delete;
+    LogRecord& operator=(const LogRecord&) = delete;
+
+    LogRecord& operator<<(const char* text);
+    LogRecord& operator<<(const std::string& text);
+    LogRecord& operator<<(const std::string_view text);
+    LogRecord& operator<<(const char c);
+    LogRecord& operator<<(const bool b);
+
+    template<typename T> requires std::is_arithmetic_v<T>
+    LogRecord& operator<<(const T value)
+    {
+        // Streamed like std::ostream does
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            const double d = value;
+            append(LogArg::Double, &d, sizeof(d));
+        }
+        else if constexpr (sizeof(T) == 1)
+        {
+            const char c = static_cast<char>(value);
+            append(LogArg::Char, &c, sizeof(c));
+        }
+        else if constexpr (std::is_signed_v<T>)
+        {
+            const int64_t i = value;
+            append(LogArg::Int, &i, sizeof(i));
+        }
+        else
+        {
+            const uint64_t u = value;
+            append(LogArg::UInt, &u, sizeof(u));
+        }
+        return *this;
+    }
+
+    static const uint32_t MAX_SIZE = 1024;
+
+ private:
+    void append(const LogArg type, const void* data, const uint32_t size);
+
+    uint32_t                            _size = 0;
+    std::array<std::byte, MAX_SIZE>     _data;
+};
+
+class LogRing;
+
+// Records are queued without locks in a ring per thread and written to stderr
+// by a background thread, a full ring drops its records rather than waiting
+// A thread only takes a lock for its first record, to register its ring
+class Logger
+{
+ public:
+    static Logger& instance();
+
+    // Producer side, false when the record was dropped
+    bool push(const std::byte* data, const uint32_t size);
+
+    // Write every queued record now, from any thread
+    void flush();
+
+ private:
+    Logger();
+
+    static void shutdown();
+
+    LogRing& threadRing();
+    void writerLoop();
+    bool drain();
+    void write(const std::byte* data, const uint32_t size) const;
+
+    std::mutex              _ringsMutex;    // Registration of the rings
+    std::vector<LogRing*>   _rings;
+
+    std::mutex              _writeMutex;    // A single consumer at a time
+    std::vector<LogRing*>   _drainedRings;
+    std::atomic<bool>       _stop = false;
+    std::thread             _writer;
+};
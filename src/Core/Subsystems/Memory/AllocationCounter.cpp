@@ -0,0 +1,109 @@
+#include "AllocationCounter.h"
+#include "MemoryTracker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    std::atomic<uint64_t> g_allocations = 0;
+    std::atomic<uint64_t> g_allocatedBytes = 0;
+
+    // Right before each block handed out, to account for it when freed
+    struct AllocationHeader
+    {
+        uint64_t    size;
+        uint32_t    offset;     // Of the block from the start of the allocation
+        MemoryTag   tag;
+    };
+    static_assert(sizeof(AllocationHeader) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+
+    void* allocate(const std::size_t size, const std::size_t alignment)
+    {
+        // The header takes a whole alignment unit so the block stays aligned
+        const std::size_t align = std::max<std::size_t>(alignment, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+        const std::size_t bytes = align + size;
+        std::byte* allocation = static_cast<std::byte*>(align == __STDCPP_DEFAULT_NEW_ALIGNMENT__
+            ? std::malloc(bytes)
+            : std::aligned_alloc(align, (bytes + align - 1) / align * align));
+        if (allocation == nullptr)
+        {
+            return nullptr;
+        }
+
+        const MemoryTag tag = MemoryTracker::currentTag();
+        std::byte* block = allocation + align;
+        new (block - sizeof(AllocationHeader)) AllocationHeader{ size, static_cast<uint32_t>(align), tag };
+
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+        g_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        MemoryTracker::allocated(tag, size);
+        return block;
+    }
+
+    void deallocate(void* pointer)
+    {
+        if (pointer == nullptr)
+        {
+            return;
+        }
+
+        std::byte* block = static_cast<std::byte*>(pointer);
+        const AllocationHeader* header = reinterpret_cast<const AllocationHeader*>(block - sizeof(AllocationHeader));
+        MemoryTracker::freed(header->tag, header->size);
+        std::free(block - header->offset);
+    }
+
+    // Without exceptions a failed allocation aborts once the new handler gives up
+    void* allocateOrAbort(const std::size_t size, const std::size_t alignment)
+    {
+        while (true)
+        {
+            if (void* pointer = allocate(size, alignment))
+            {
+                return pointer;
+            }
+            const std::new_handler handler = std::get_new_handler();
+            if (handler == nullptr)
+            {
+                std::abort();
+            }
+            handler();
+        }
+    }
+}
+
+uint64_t AllocationCounter::allocations()
+{
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+uint64_t AllocationCounter::allocatedBytes()
+{
+    return g_allocatedBytes.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size)                                                    { return allocateOrAbort(size, 0); }
+void* operator new[](std::size_t size)                                                  { return allocateOrAbort(size, 0); }
+void* operator new(std::size_t size, std::align_val_t alignment)                        { return allocateOrAbort(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment)                      { return allocateOrAbort(size, static_cast<std::size_t>(alignment)); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept                    { return allocate(size, 0); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept                  { return allocate(size, 0); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept   { return allocate(size, static_cast<std::size_t>(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocate(size, static_cast<std::size_t>(alignment)); }
+
+void operator delete(void* pointer) noexcept                                            { deallocate(pointer); }
+void operator delete[](void* pointer) noexcept                                          { deallocate(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept                               { deallocate(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept                             { deallocate(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept                          { deallocate(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept                        { deallocate(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept             { deallocate(pointer); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept           { deallocate(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept                     { deallocate(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept                   { deallocate(pointer); }
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept   { deallocate(pointer); }
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { deallocate(pointer); }
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+// Heap allocations made through the global operator new of every thread,
+// counted by its replacement in AllocationCounter.cpp which also feeds the MemoryTracker
+// A steady state frame is expected to make none, its scratch memory comes from the FrameArena
+class AllocationCounter
+{
+ public:
+    static uint64_t allocations();
+    static uint64_t allocatedBytes();
+};
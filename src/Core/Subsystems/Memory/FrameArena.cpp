@@ -0,0 +1,69 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+
+FrameArena& FrameArena::local()
+{
+    thread_local FrameArena arena;
+    return arena;
+}
+
+void FrameArena::reset()
+{
+    _block = 0;
+    _offset = 0;
+    _used = 0;
+}
+
+uint64_t FrameArena::used() const
+{
+    return _used + _offset;
+}
+
+uint64_t FrameArena::capacity() const
+{
+    uint64_t capacity = 0;
+    for (const auto& block : _blocks)
+    {
+        capacity += block.size;
+    }
+    return capacity;
+}
+
+void* FrameArena::do_allocate(const std::size_t bytes, const std::size_t alignment)
+{
+    // Next block with enough room, a new one past the last
+    while (true)
+    {
+        if (_block < _blocks.size())
+        {
+            Block& block = _blocks[_block];
+            const uint64_t address = reinterpret_cast<uint64_t>(block.data.get()) + _offset;
+            const uint64_t aligned = (address + alignment - 1) / alignment * alignment;
+            const uint64_t offset = _offset + (aligned - address);
+            if (offset + bytes <= block.size)
+            {
+                _offset = offset + bytes;
+                return block.data.get() + offset;
+            }
+
+            _used += _offset;
+            ++_block;
+            _offset = 0;
+            continue;
+        }
+
+        const uint64_t size = std::max<uint64_t>(BLOCK_SIZE, bytes + alignment);
+        _blocks.push_back({ std::make_unique_for_overwrite<std::byte[]>(size), size });
+    }
+}
+
+// Released by reset()
+void FrameArena::do_deallocate(void* pointer, const std::size_t bytes, const std::size_t alignment)
+{
+}
+
+bool FrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
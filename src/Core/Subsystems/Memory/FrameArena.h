@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+// Bump allocator of the scratch memory of a thread for the current frame
+// Nothing is freed on its own, reset() releases everything at once at the end
+// of the frame of its thread. The blocks are kept, so once the arena grew to
+// the largest frame a frame does not touch the heap anymore
+class FrameArena : public std::pmr::memory_resource
+{
+ public:
+    // Arena of the calling thread
+    static FrameArena& local();
+
+    // Everything allocated since the previous reset is invalidated
+    void reset();
+
+    uint64_t used() const;
+    uint64_t capacity() const;
+
+    static constexpr uint64_t BLOCK_SIZE = 1 << 20;
+
+ private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    struct Block
+    {
+        std::unique_ptr<std::byte[]>    data;
+        uint64_t                        size;
+    };
+
+    std::vector<Block>  _blocks;
+    uint64_t            _block = 0;     // Block being filled
+    uint64_t            _offset = 0;    // Bytes used in that block
+    uint64_t            _used = 0;      // Bytes used in the previous blocks
+};
+
+// Containers living until the end of the frame, allocated from the arena of the thread
+// They must not outlive the frame nor be grown from another thread
+template<typename T>
+using FrameVector = std::pmr::vector<T>;
+using FrameString = std::pmr::string;
+
+template<typename T>
+FrameVector<T> makeFrameVector(const uint64_t reserved = 0)
+{
+    FrameVector<T> vector(&FrameArena::local());
+    vector.reserve(reserved);
+    return vector;
+}
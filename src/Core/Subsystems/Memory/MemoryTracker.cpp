@@ -0,0 +1,167 @@
+#include "MemoryTracker.h"
+
+#include "../../utils.h"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+namespace
+{
+    const uint64_t TAG_COUNT = static_cast<uint64_t>(MemoryTag::Count);
+
+    struct Counter
+    {
+        std::atomic<uint64_t> current = 0;
+        std::atomic<uint64_t> peak = 0;
+
+        void add(const uint64_t bytes)
+        {
+            const uint64_t value = current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+            uint64_t peakValue = peak.load(std::memory_order_relaxed);
+            while (value > peakValue && !peak.compare_exchange_weak(peakValue, value, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        void sub(const uint64_t bytes)
+        {
+            current.fetch_sub(bytes, std::memory_order_relaxed);
+        }
+
+        MemoryUsage usage() const
+        {
+            return { current.load(std::memory_order_relaxed), peak.load(std::memory_order_relaxed) };
+        }
+    };
+
+    // A counter per tag then the total, constant initialized as operator new may run before main
+    std::array<Counter, TAG_COUNT + 1> g_cpu;
+    std::array<Counter, TAG_COUNT + 1> g_gpu;
+
+    thread_local MemoryTag g_threadTag = MemoryTag::Other;
+
+    struct GpuAllocation
+    {
+        MemoryTag   tag;
+        uint64_t    bytes;
+    };
+
+    // Storage of the live GL objects, the renderer is created during static initialization
+    std::mutex g_gpuMutex;
+    std::unordered_map<uint64_t, GpuAllocation>& gpuAllocations()
+    {
+        static std::unordered_map<uint64_t, GpuAllocation> allocations;
+        return allocations;
+    }
+
+    uint64_t gpuKey(const GpuResource resource, const uint32_t name)
+    {
+        return static_cast<uint64_t>(resource) << 32 | name;
+    }
+}
+
+MemoryScope::MemoryScope(const MemoryTag tag) : _previous(g_threadTag)
+{
+    g_threadTag = tag;
+}
+
+MemoryScope::~MemoryScope()
+{
+    g_threadTag = _previous;
+}
+
+MemoryTag MemoryTracker::currentTag()
+{
+    return g_threadTag;
+}
+
+const char* MemoryTracker::name(const MemoryTag tag)
+{
+    switch (tag)
+    {
+        case MemoryTag::ECS:
+            return "ECS";
+        case MemoryTag::World:
+            return "World";
+        case MemoryTag::Renderer:
+            return "Renderer";
+        case MemoryTag::Shader:
+            return "Shader";
+        default:
+            return "Other";
+    }
+}
+
+void MemoryTracker::allocated(const MemoryTag tag, const uint64_t bytes)
+{
+    g_cpu[static_cast<uint64_t>(tag)].add(bytes);
+    g_cpu[TAG_COUNT].add(bytes);
+}
+
+void MemoryTracker::freed(const MemoryTag tag, const uint64_t bytes)
+{
+    g_cpu[static_cast<uint64_t>(tag)].sub(bytes);
+    g_cpu[TAG_COUNT].sub(bytes);
+}
+
+void MemoryTracker::trackGpu(const MemoryTag tag, const GpuResource resource, const uint32_t name, const uint64_t bytes)
+{
+    std::lock_guard lock(g_gpuMutex);
+    auto& allocation = gpuAllocations()[gpuKey(resource, name)];
+    g_gpu[static_cast<uint64_t>(allocation.tag)].sub(allocation.bytes);
+    g_gpu[TAG_COUNT].sub(allocation.bytes);
+
+    allocation = { tag, bytes };
+    g_gpu[static_cast<uint64_t>(tag)].add(bytes);
+    g_gpu[TAG_COUNT].add(bytes);
+}
+
+void MemoryTracker::untrackGpu(const GpuResource resource, const uint32_t name)
+{
+    std::lock_guard lock(g_gpuMutex);
+    const auto allocation = gpuAllocations().find(gpuKey(resource, name));
+    if (allocation != gpuAllocations().end())
+    {
+        g_gpu[static_cast<uint64_t>(allocation->second.tag)].sub(allocation->second.bytes);
+        g_gpu[TAG_COUNT].sub(allocation->second.bytes);
+        gpuAllocations().erase(allocation);
+    }
+}
+
+MemoryUsage MemoryTracker::cpu(const MemoryTag tag)
+{
+    return g_cpu[static_cast<uint64_t>(tag)].usage();
+}
+
+MemoryUsage MemoryTracker::gpu(const MemoryTag tag)
+{
+    return g_gpu[static_cast<uint64_t>(tag)].usage();
+}
+
+MemoryUsage MemoryTracker::cpuTotal()
+{
+    return g_cpu[TAG_COUNT].usage();
+}
+
+MemoryUsage MemoryTracker::gpuTotal()
+{
+    return g_gpu[TAG_COUNT].usage();
+}
+
+void MemoryTracker::report()
+{
+    const auto line = [](const char* name, const MemoryUsage cpu, const MemoryUsage gpu)
+    {
+        INFO("Memory " << name << ": CPU " << cpu.current / 1024 << " KiB (peak " << cpu.peak / 1024 << " KiB)"
+             << ", GPU " << gpu.current / 1024 << " KiB (peak " << gpu.peak / 1024 << " KiB)");
+    };
+
+    for (uint64_t i = 0; i < TAG_COUNT; ++i)
+    {
+        const MemoryTag tag = static_cast<MemoryTag>(i);
+        line(name(tag), cpu(tag), gpu(tag));
+    }
+    line("Total", cpuTotal(), gpuTotal());
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+
+// Subsystem owning a piece of memory
+enum class MemoryTag : uint8_t
+{
+    Other,
+    ECS,
+    World,
+    Renderer,
+    Shader,
+    Count,
+};
+
+// GL objects have a name space per kind
+enum class GpuResource : uint8_t
+{
+    Buffer,
+    Texture,
+    Renderbuffer,
+};
+
+struct MemoryUsage
+{
+    uint64_t current = 0;
+    uint64_t peak = 0;
+};
+
+// Heap allocations of this thread are tagged with the innermost scope
+class MemoryScope
+{
+ public:
+    explicit MemoryScope(const MemoryTag tag);
+    ~MemoryScope();
+
+    MemoryScope(const MemoryScope&) = delete;
+    MemoryScope& operator=(const MemoryScope&) = delete;
+
+ private:
+    MemoryTag _previous;
+};
+
+// Current and peak bytes per subsystem, on the heap and on the GPU
+// The heap side is fed by the operator new replacement in AllocationCounter.cpp,
+// the GPU side by the code creating the GL storage
+class MemoryTracker
+{
+ public:
+    static MemoryTag currentTag();
+    static const char* name(const MemoryTag tag);
+
+    // Heap side, a block is freed under the tag it was allocated with
+    static void allocated(const MemoryTag tag, const uint64_t bytes);
+    static void freed(const MemoryTag tag, const uint64_t bytes);
+
+    // GPU side, new storage of an object replaces its previous one
+    static void trackGpu(const MemoryTag tag, const GpuResource resource, const uint32_t name, const uint64_t bytes);
+    static void untrackGpu(const GpuResource resource, const uint32_t name);
+
+    static MemoryUsage cpu(const MemoryTag tag);
+    static MemoryUsage gpu(const MemoryTag tag);
+    static MemoryUsage cpuTotal();
+    static MemoryUsage gpuTotal();
+
+    // A line per subsystem then the totals
+    static void report();
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "../../../Components/PointLight.h"
+
+struct Primitive;
+
+// Camera of the frame, std140 layout of the CameraBlock uniform block
+struct CameraData
+{
+    glm::mat4   view;
+    glm::mat4   projection;
+    glm::mat4   invProjection;
+    glm::mat4   invView;
+    glm::vec4   viewPos;
+};
+
+// Primitive drawn with the transform of its node
+// The world is immutable once loaded so the primitive is referenced, not copied
+struct DrawItem
+{
+    glm::mat4           model;
+    const Primitive*    primitive;
+};
+
+// Everything needed to draw a frame, built by the simulation thread then only
+// read by the render thread until it is drawn
+struct FramePacket
+{
+    CameraData              camera {};
+    uint32_t                outputWidth     = 0;
+    uint32_t                outputHeight    = 0;
+    float                   frameTime       = 0.0f;     // Previous frame, drives the dynamic resolution
+    float                   targetFrameTime = 0.0f;     // Frame time held by the dynamic resolution, off at 0
+
+    std::vector<DrawItem>   drawList;
+
+    // Interpolated lights, only the ranges changed since the previous packet are sent, packed in order
+    uint32_t                lightCount      = 0;
+    std::vector<PointLight> lights;
+    std::vector<glm::uvec2> dirtyLightRanges;
+    bool                    lightsChanged   = false;    // The culling structure has to be rebuilt
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include "../Memory/MemoryTracker.h"
+
+// Bytes per texel of the uncompressed formats in use, as drivers usually store them
+// RGB is padded to 4 bytes, depth to 32 bits
+inline uint64_t texelSize(const GLenum internalFormat)
+{
+    switch (internalFormat)
+    {
+        case GL_RGBA32F:
+            return 16;
+        case GL_RG32UI:
+        case GL_RGBA16F:
+            return 8;
+        default:
+            return 4;
+    }
+}
+
+inline void trackBuffer(const MemoryTag tag, const GLuint buffer, const uint64_t size)
+{
+    MemoryTracker::trackGpu(tag, GpuResource::Buffer, buffer, size);
+}
+
+inline void trackTexture(const MemoryTag tag, const GLuint texture, const GLenum internalFormat, const uint64_t width, const uint64_t height)
+{
+    MemoryTracker::trackGpu(tag, GpuResource::Texture, texture, width * height * texelSize(internalFormat));
+}
+
+inline void trackRenderbuffer(const MemoryTag tag, const GLuint renderbuffer, const GLenum internalFormat, const uint64_t width, const uint64_t height)
+{
+    MemoryTracker::trackGpu(tag, GpuResource::Renderbuffer, renderbuffer, width * height * texelSize(internalFormat));
+}
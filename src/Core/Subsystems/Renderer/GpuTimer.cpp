@@ -0,0 +1,114 @@
+#include "GpuTimer.h"
+
+const char* renderPassName(const RenderPass pass)
+{
+    switch (pass)
+    {
+        case RenderPass::LightUpload:
+            return "lightUpload";
+        case RenderPass::Depth:
+            return "depth";
+        case RenderPass::LightCulling:
+            return "lightCulling";
+        case RenderPass::Forward:
+            return "forward";
+        case RenderPass::Present:
+            return "present";
+        default:
+            return "unknown";
+    }
+}
+
+void GpuTimer::init()
+{
+    for (auto& queries : _queries)
+    {
+        glGenQueries(queries.size(), queries.data());
+    }
+}
+
+void GpuTimer::setEnabled(const bool enabled)
+{
+    if (!enabled)
+    {
+        flush();
+    }
+    _enabled = enabled;
+}
+
+bool GpuTimer::enabled() const
+{
+    return _enabled;
+}
+
+void GpuTimer::beginFrame()
+{
+    if (!_enabled)
+    {
+        return;
+    }
+
+    // The slot is reused, its frame has to be read back first
+    _frame = (_frame + 1) % FRAME_LATENCY;
+    if (_pending[_frame])
+    {
+        readFrame(_frame);
+    }
+    _inFrame = true;
+}
+
+void GpuTimer::beginPass(const RenderPass pass)
+{
+    if (_inFrame)
+    {
+        glQueryCounter(_queries[_frame][static_cast<uint32_t>(pass)], GL_TIMESTAMP);
+    }
+}
+
+void GpuTimer::endFrame()
+{
+    if (!_inFrame)
+    {
+        return;
+    }
+    glQueryCounter(_queries[_frame][RENDER_PASS_COUNT], GL_TIMESTAMP);
+    _pending[_frame] = true;
+    _inFrame = false;
+}
+
+void GpuTimer::flush()
+{
+    // Oldest frame first
+    for (uint32_t i = 1; i <= FRAME_LATENCY; ++i)
+    {
+        const uint32_t frame = (_frame + i) % FRAME_LATENCY;
+        if (_pending[frame])
+        {
+            readFrame(frame);
+        }
+    }
+}
+
+const std::vector<PassTimings>& GpuTimer::takeResults()
+{
+    _takenResults.swap(_results);
+    _results.clear();
+    return _takenResults;
+}
+
+void GpuTimer::readFrame(const uint32_t frame)
+{
+    std::array<GLuint64, RENDER_PASS_COUNT + 1> timestamps;
+    for (uint32_t i = 0; i < timestamps.size(); ++i)
+    {
+        glGetQueryObjectui64v(_queries[frame][i], GL_QUERY_RESULT, &timestamps[i]);
+    }
+
+    PassTimings timings;
+    for (uint32_t pass = 0; pass < RENDER_PASS_COUNT; ++pass)
+    {
+        timings[pass] = static_cast<double>(timestamps[pass + 1] - timestamps[pass]) / 1e6;
+    }
+    _results.push_back(timings);
+    _pending[frame] = false;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Passes of a frame, in submission order
+enum class RenderPass : uint32_t
+{
+    LightUpload,    // Light upload and culling structure build
+    Depth,
+    LightCulling,
+    Forward,
+    Present,
+    Count
+};
+
+const uint32_t RENDER_PASS_COUNT = static_cast<uint32_t>(RenderPass::Count);
+
+const char* renderPassName(const RenderPass pass);
+
+// GPU time of each pass of a frame, in milliseconds
+using PassTimings = std::array<double, RENDER_PASS_COUNT>;
+
+// GPU durations of the passes measured with timestamp queries
+// A frame is read back FRAME_LATENCY frames later so the queries do not stall
+// the pipeline, the timestamps of a frame only block when the GPU is that late
+class GpuTimer
+{
+ public:
+    static constexpr uint32_t FRAME_LATENCY = 4;
+
+    void init();
+    void setEnabled(const bool enabled);
+    bool enabled() const;
+
+    void beginFrame();
+    void beginPass(const RenderPass pass);
+    void endFrame();
+
+    // Wait for the frames in flight
+    void flush();
+
+    // Timings of the frames read back since the last call, oldest first
+    // Valid until the next call, the storage is reused
+    const std::vector<PassTimings>& takeResults();
+
+ private:
+    void readFrame(const uint32_t frame);
+
+    // One timestamp at the start of each pass and one at the end of the frame
+    using FrameQueries = std::array<GLuint, RENDER_PASS_COUNT + 1>;
+
+    std::array<FrameQueries, FRAME_LATENCY> _queries {};
+    std::array<bool, FRAME_LATENCY>         _pending {};
+    uint32_t                                _frame = 0;
+    bool                                    _enabled = false;
+    bool                                    _inFrame = false;
+
+    std::vector<PassTimings>                _results;
+    std::vector<PassTimings>                _takenResults;
+};
@@ -0,0 +1,171 @@
+#include "LightBVH.h"
+
+#include "LightBounds.h"
+#include "GpuMemory.h"
+
+#include <cstdio>
+
+// Create the buffer on first use, reallocate its storage otherwise
+static void allocateStorageBuffer(GLuint& buffer, const uint64_t size)
+{
+    if (buffer == 0)
+    {
+        glGenBuffers(1, &buffer);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, size, nullptr, GL_DYNAMIC_COPY);
+    trackBuffer(MemoryTag::Renderer, buffer, size);
+}
+
+// Called again when the light capacity changes
+void LightBVH::init(const uint64_t maxLights)
+{
+    const uint64_t maxBlocks = (maxLights + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    const uint64_t maxKeys   = maxBlocks * BLOCK_SIZE;
+    const uint64_t maxLeaves = (maxLights + BVH_WIDTH - 1) / BVH_WIDTH;
+
+    for (uint8_t i = 0; i < 2; ++i)
+    {
+        allocateStorageBuffer(_keysBuffers[i],   maxKeys * sizeof(uint32_t));
+        allocateStorageBuffer(_valuesBuffers[i], maxKeys * sizeof(uint32_t));
+    }
+    allocateStorageBuffer(_localKeysBuffer,     maxKeys * sizeof(uint32_t));
+    allocateStorageBuffer(_localValuesBuffer,   maxKeys * sizeof(uint32_t));
+    allocateStorageBuffer(_histogramBuffer,     maxBlocks * RADIX * sizeof(uint32_t));
+    allocateStorageBuffer(_blockOffsetsBuffer,  maxBlocks * RADIX * sizeof(uint32_t));
+    allocateStorageBuffer(_totalBuffer,         sizeof(uint32_t));
+
+    // Upper levels add less than a node per BVH_WIDTH - 1 nodes below
+    allocateStorageBuffer(_nodesBuffer,         (2 * maxLeaves + MAX_BVH_LEVELS) * 2 * sizeof(glm::vec4));
+}
+
+void LightBVH::build(const std::vector<PointLight>& lights, const GLuint lightsBuffer)
+{
+    _numLights = lights.size();
+    computeLevels();
+
+    if (_numLights == 0)
+    {
+        return;
+    }
+
+    const GLuint numBlocks = static_cast<GLuint>((_numLights + BLOCK_SIZE - 1) / BLOCK_SIZE);
+    sortLights(lights, lightsBuffer, numBlocks);
+    buildHierarchy(lightsBuffer);
+}
+
+// Nodes of every level, from the leaves to the root
+void LightBVH::computeLevels()
+{
+    _numLevels = 0;
+    if (_numLights == 0)
+    {
+        return;
+    }
+
+    uint64_t count = _numLights;
+    int offset = 0;
+    do
+    {
+        ASSERT(_numLevels < MAX_BVH_LEVELS, "Too many lights for the light BVH");
+
+        count = (count + BVH_WIDTH - 1) / BVH_WIDTH;
+        _levelOffsets[_numLevels] = offset;
+        _levelCounts[_numLevels] = static_cast<int>(count);
+        offset += static_cast<int>(count);
+        ++_numLevels;
+    }
+    while (count > 1);
+}
+
+void LightBVH::sortLights(const std::vector<PointLight>& lights, const GLuint lightsBuffer, const GLuint numBlocks)
+{
+    const LightBounds bounds = computeLightBounds(lights);
+
+    // Morton code of every light
+    _mortonShader.use();
+    _mortonShader.set1i("numLights", _numLights);
+    _mortonShader.set3f("boundsMin", bounds.min);
+    _mortonShader.set3f("boundsMax", bounds.max);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, lightsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, _keysBuffers[0]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, _valuesBuffers[0]);
+    glDispatchCompute(numBlocks, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    // Radix sort of the light indices by Morton code, RADIX_BITS per pass
+    for (uint32_t shift = 0; shift < 32; shift += RADIX_BITS)
+    {
+        _radixSortLocalShader.use();
+        _radixSortLocalShader.set1i("shift", shift);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _keysBuffers[0]);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, _valuesBuffers[0]);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, _localKeysBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, _localValuesBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, _histogramBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, _blockOffsetsBuffer);
+        glDispatchCompute(numBlocks, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        _prefixSumShader.use();
+        _prefixSumShader.set1i("count", numBlocks * RADIX);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _histogramBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, _totalBuffer);
+        glDispatchCompute(1, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        _radixSortScatterShader.use();
+        _radixSortScatterShader.set1i("shift", shift);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _localKeysBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, _localValuesBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, _keysBuffers[1]);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, _valuesBuffers[1]);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, _histogramBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, _blockOffsetsBuffer);
+        glDispatchCompute(numBlocks, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        std::swap(_keysBuffers[0], _keysBuffers[1]);
+        std::swap(_valuesBuffers[0], _valuesBuffers[1]);
+    }
+}
+
+// Bottom-up AABBs of the nodes, one dispatch per level
+void LightBVH::buildHierarchy(const GLuint lightsBuffer)
+{
+    _hierarchyShader.use();
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, lightsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, _valuesBuffers[0]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, _nodesBuffer);
+
+    for (uint64_t level = 0; level < _numLevels; ++level)
+    {
+        _hierarchyShader.set1i("level",       level);
+        _hierarchyShader.set1i("childOffset", level == 0 ? 0 : _levelOffsets[level - 1]);
+        _hierarchyShader.set1i("childCount",  level == 0 ? _numLights : _levelCounts[level - 1]);
+        _hierarchyShader.set1i("nodeOffset",  _levelOffsets[level]);
+        _hierarchyShader.set1i("nodeCount",   _levelCounts[level]);
+        glDispatchCompute((_levelCounts[level] + 63) / 64, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+}
+
+void LightBVH::bind(const GLuint indicesBinding, const GLuint nodesBinding) const
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, indicesBinding, _valuesBuffers[0]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, nodesBinding,   _nodesBuffer);
+}
+
+void LightBVH::setUniforms(const Shader& shader) const
+{
+    shader.set1i("bvhLevels", _numLevels);
+    // Names formatted on the stack, set every frame
+    char name[32];
+    for (uint64_t level = 0; level < _numLevels; ++level)
+    {
+        std::snprintf(name, sizeof(name), "bvhLevelOffset[%u]", static_cast<unsigned>(level));
+        shader.set1i(name, _levelOffsets[level]);
+        std::snprintf(name, sizeof(name), "bvhLevelCount[%u]", static_cast<unsigned>(level));
+        shader.set1i(name, _levelCounts[level]);
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include <array>
+#include <vector>
+
+#include "Shader.h"
+#include "../../../Components/PointLight.h"
+
+// Lights sorted by Morton code on the GPU with a radix sort and an implicit
+// BVH_WIDTH wide hierarchy built over them, for very large light counts
+class LightBVH
+{
+ public:
+    void init(const uint64_t maxLights);
+    void build(const std::vector<PointLight>& lights, const GLuint lightsBuffer);
+    void bind(const GLuint indicesBinding, const GLuint nodesBinding) const;
+    void setUniforms(const Shader& shader) const;
+
+    static constexpr uint64_t  BLOCK_SIZE      = 256; // Local size of the sorting shaders
+    static constexpr uint64_t  RADIX_BITS      = 4;
+    static constexpr uint64_t  RADIX           = 1 << RADIX_BITS;
+    static constexpr uint64_t  BVH_WIDTH       = 32;
+    static constexpr uint64_t  MAX_BVH_LEVELS  = 8;
+
+ private:
+    void computeLevels();
+    void sortLights(const std::vector<PointLight>& lights, const GLuint lightsBuffer, const GLuint numBlocks);
+    void buildHierarchy(const GLuint lightsBuffer);
+
+    Shader _mortonShader            {"./shaders/lightMorton.comp"};
+    Shader _radixSortLocalShader    {"./shaders/radixSortLocal.comp"};
+    Shader _radixSortScatterShader  {"./shaders/radixSortScatter.comp"};
+    Shader _prefixSumShader         {"./shaders/prefixSum.comp"};
+    Shader _hierarchyShader         {"./shaders/lightBVH.comp"};
+
+    uint64_t _numLights = 0;
+    uint64_t _numLevels = 0;
+    std::array<int, MAX_BVH_LEVELS> _levelOffsets {};
+    std::array<int, MAX_BVH_LEVELS> _levelCounts {};
+
+    // Ping-pong sorting buffers, the sorted result ends in index 0
+    std::array<GLuint, 2> _keysBuffers {};
+    std::array<GLuint, 2> _valuesBuffers {};
+    GLuint _localKeysBuffer     = 0;
+    GLuint _localValuesBuffer   = 0;
+    GLuint _histogramBuffer     = 0;
+    GLuint _blockOffsetsBuffer  = 0;
+    GLuint _totalBuffer         = 0;
+
+    GLuint _nodesBuffer         = 0;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <algorithm>
+#include <limits>
+
+#include "../Jobs/ThreadPool.h"
+#include "../Memory/FrameArena.h"
+#include "../../../Components/PointLight.h"
+
+// Lights per chunk of the parallel light loops
+const uint64_t LIGHT_CHUNK_SIZE = 4096;
+
+struct LightBounds
+{
+    glm::vec3   min;
+    glm::vec3   max;
+    float       range; // Largest light range
+};
+
+// Bounds of the light centers, reduced in parallel on the render pool
+// The partial bounds are combined in chunk order
+inline LightBounds computeLightBounds(const std::vector<PointLight>& lights)
+{
+    const LightBounds empty
+    {
+        .min = glm::vec3(std::numeric_limits<float>::max()),
+        .max = glm::vec3(std::numeric_limits<float>::lowest()),
+        .range = 0.0f
+    };
+
+    FrameVector<LightBounds> partials = makeFrameVector<LightBounds>();
+    partials.assign((lights.size() + LIGHT_CHUNK_SIZE - 1) / LIGHT_CHUNK_SIZE, empty);
+
+    auto chunkJob = [&](uint64_t chunk)
+    {
+        LightBounds& bounds = partials[chunk];
+        const uint64_t last = std::min((chunk + 1) * LIGHT_CHUNK_SIZE, lights.size());
+        for (uint64_t i = chunk * LIGHT_CHUNK_SIZE; i < last; ++i)
+        {
+            const glm::vec3 position = glm::vec3(lights[i].position);
+            bounds.min = glm::min(bounds.min, position);
+            bounds.max = glm::max(bounds.max, position);
+            bounds.range = std::max(bounds.range, lights[i].range);
+        }
+    };
+    ThreadPool::render().parallelFor(partials.size(), chunkJob);
+
+    LightBounds bounds = empty;
+    for (const auto& partial : partials)
+    {
+        bounds = LightBounds{glm::min(bounds.min, partial.min), glm::max(bounds.max, partial.max), std::max(bounds.range, partial.range)};
+    }
+    return bounds;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+// Acceleration structure used by the light culling
+enum class LightCulling
+{
+    Grid,   // CPU built uniform grid
+    BVH,    // GPU Morton sorted lights and BVH, for very large light counts
+};
+
+// Layout of the per tile light index list
+enum class LightListLayout
+{
+    PerTileCap, // Single pass, at most MAX_LIGHTS_PER_TILE lights per tile
+    Compact,    // Count pass, prefix sum and write pass, no per tile limit
+};
+
+// Light culling statistics read back from the GPU
+struct LightCullingStats
+{
+    uint32_t    totalLightIndices   = 0; // Light indices needed by all the tiles
+    uint32_t    maxTileLights       = 0; // Most lights in a single tile
+    uint32_t    droppedLightIndices = 0; // Light indices lost to the per tile cap
+};
+
+const char* lightCullingName(const LightCulling lightCulling);
+const char* lightListLayoutName(const LightListLayout lightListLayout);
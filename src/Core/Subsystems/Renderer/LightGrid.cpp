@@ -0,0 +1,114 @@
+#include "LightGrid.h"
+
+#include "LightBounds.h"
+#include "GpuMemory.h"
+
+#include <algorithm>
+
+// Called again when the light capacity changes
+void LightGrid::init(const uint64_t maxLights)
+{
+    const uint64_t maxCells = MAX_CELLS_PER_AXIS * MAX_CELLS_PER_AXIS * MAX_CELLS_PER_AXIS;
+
+    if (_cellsBuffer == 0)
+    {
+        glGenBuffers(1, &_cellsBuffer);
+        glGenBuffers(1, &_indicesBuffer);
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _cellsBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, maxCells * sizeof(glm::uvec2), nullptr, GL_DYNAMIC_DRAW);
+    trackBuffer(MemoryTag::Renderer, _cellsBuffer, maxCells * sizeof(glm::uvec2));
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _indicesBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, maxLights * sizeof(uint32_t), nullptr, GL_DYNAMIC_DRAW);
+    trackBuffer(MemoryTag::Renderer, _indicesBuffer, maxLights * sizeof(uint32_t));
+
+    _cells.reserve(maxCells);
+    _lightCells.reserve(maxLights);
+    _lightIndices.reserve(maxLights);
+}
+
+// Sort the light indices by cell with a counting sort
+void LightGrid::build(const std::vector<PointLight>& lights)
+{
+    const LightBounds bounds = computeLightBounds(lights);
+
+    if (lights.empty())
+    {
+        _origin     = glm::vec3(0);
+        _dims       = glm::ivec3(1);
+        _cellSize   = 1.0f;
+        _maxRange   = 0.0f;
+    }
+    else
+    {
+        // A cell is at least as large as a light so a light only reaches
+        // its neighbour cells, and grows to keep the grid size bounded
+        const glm::vec3 extent = glm::max(bounds.max - bounds.min, glm::vec3(1e-3f));
+        const float largestExtent = std::max({extent.x, extent.y, extent.z});
+        const int maxCellsPerAxis = static_cast<int>(MAX_CELLS_PER_AXIS);
+
+        _origin     = bounds.min;
+        _maxRange   = bounds.range;
+        _cellSize   = std::max(2.0f * bounds.range, largestExtent / maxCellsPerAxis);
+        _dims       = glm::clamp(glm::ivec3(glm::ceil(extent / _cellSize)), glm::ivec3(1), glm::ivec3(maxCellsPerAxis));
+    }
+
+    // Cell of each light, in parallel on the render pool
+    _lightCells.resize(lights.size());
+    auto chunkJob = [&](uint64_t chunk)
+    {
+        const uint64_t last = std::min((chunk + 1) * LIGHT_CHUNK_SIZE, lights.size());
+        for (uint64_t i = chunk * LIGHT_CHUNK_SIZE; i < last; ++i)
+        {
+            const glm::ivec3 cell = glm::clamp(glm::ivec3((glm::vec3(lights[i].position) - _origin) / _cellSize), glm::ivec3(0), _dims - 1);
+            _lightCells[i] = static_cast<uint32_t>(cell.x + _dims.x * (cell.y + _dims.y * cell.z));
+        }
+    };
+    ThreadPool::render().parallelFor((lights.size() + LIGHT_CHUNK_SIZE - 1) / LIGHT_CHUNK_SIZE, chunkJob);
+
+    // Count the lights of each cell
+    _cells.assign(_dims.x * _dims.y * _dims.z, glm::uvec2(0));
+    for (const auto cell : _lightCells)
+    {
+        ++_cells[cell].y;
+    }
+
+    // Offsets of the cells into the sorted indices
+    uint32_t offset = 0;
+    for (auto& cell : _cells)
+    {
+        cell.x = offset;
+        offset += cell.y;
+        cell.y = 0;
+    }
+
+    // Scatter the light indices into their cells
+    _lightIndices.resize(lights.size());
+    for (uint32_t i = 0; i < _lightCells.size(); ++i)
+    {
+        auto& cell = _cells[_lightCells[i]];
+        _lightIndices[cell.x + cell.y] = i;
+        ++cell.y;
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _cellsBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, _cells.size() * sizeof(glm::uvec2), _cells.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _indicesBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, _lightIndices.size() * sizeof(uint32_t), _lightIndices.data());
+}
+
+void LightGrid::bind(const GLuint cellsBinding, const GLuint indicesBinding) const
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, cellsBinding,   _cellsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, indicesBinding, _indicesBuffer);
+}
+
+void LightGrid::setUniforms(const Shader& shader) const
+{
+    shader.set3f("gridOrigin",      _origin);
+    shader.set3i("gridDims",        _dims);
+    shader.set1f("gridCellSize",    _cellSize);
+    shader.set1f("maxLightRange",   _maxRange);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "Shader.h"
+#include "../../../Components/PointLight.h"
+
+// World space uniform grid of the point lights
+// Rebuilt every frame so each tile of the light culling
+// only tests the lights of the cells overlapping it
+class LightGrid
+{
+ public:
+    void init(const uint64_t maxLights);
+    void build(const std::vector<PointLight>& lights);
+    void bind(const GLuint cellsBinding, const GLuint indicesBinding) const;
+    void setUniforms(const Shader& shader) const;
+
+    static constexpr uint64_t MAX_CELLS_PER_AXIS = 64;
+
+ private:
+    glm::vec3   _origin     = glm::vec3(0);
+    glm::ivec3  _dims       = glm::ivec3(1);
+    float       _cellSize   = 1.0f;
+    float       _maxRange   = 0.0f;
+
+    std::vector<uint32_t>   _lightCells;    // Cell index of each light
+    std::vector<glm::uvec2> _cells;         // Offset and count of each cell
+    std::vector<uint32_t>   _lightIndices;  // Light indices sorted by cell
+
+    GLuint _cellsBuffer     = 0;
+    GLuint _indicesBuffer   = 0;
+};
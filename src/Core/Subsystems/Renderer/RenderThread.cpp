@@ -0,0 +1,73 @@
+#include "RenderThread.h"
+
+#include "Renderer.h"
+#include "../Window/Window.h"
+#include "../Memory/FrameArena.h"
+
+RenderThread::RenderThread(Window& window, Renderer& renderer) : _window(window), _renderer(renderer)
+{
+    // A context is current on one thread at a time
+    _window.releaseContext();
+    _thread = std::thread(&RenderThread::renderLoop, this);
+}
+
+RenderThread::~RenderThread()
+{
+    {
+        std::lock_guard lock(_mutex);
+        _stop = true;
+    }
+    _submitted.notify_one();
+    _thread.join();
+
+    _window.makeContextCurrent();
+}
+
+FramePacket& RenderThread::acquire()
+{
+    // The packet of frame N is free once frame N - MAX_FRAMES_IN_FLIGHT is drawn
+    std::unique_lock lock(_mutex);
+    _drawn.wait(lock, [this]() { return _submittedCount - _drawnCount < MAX_FRAMES_IN_FLIGHT; });
+    return _packets[_submittedCount % MAX_FRAMES_IN_FLIGHT];
+}
+
+void RenderThread::submit()
+{
+    {
+        std::lock_guard lock(_mutex);
+        ++_submittedCount;
+    }
+    _submitted.notify_one();
+}
+
+void RenderThread::renderLoop()
+{
+    _window.makeContextCurrent();
+
+    while (true)
+    {
+        uint64_t frame;
+        {
+            std::unique_lock lock(_mutex);
+            _submitted.wait(lock, [this]() { return _stop || _drawnCount < _submittedCount; });
+            if (_drawnCount == _submittedCount)
+            {
+                break;
+            }
+            frame = _drawnCount;
+        }
+
+        // The simulation does not touch a submitted packet until it is drawn
+        _renderer.drawFrame(_packets[frame % MAX_FRAMES_IN_FLIGHT]);
+        _window.swapBuffers();
+        FrameArena::local().reset();
+
+        {
+            std::lock_guard lock(_mutex);
+            ++_drawnCount;
+        }
+        _drawn.notify_one();
+    }
+
+    _window.releaseContext();
+}
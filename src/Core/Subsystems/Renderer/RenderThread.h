@@ -0,0 +1,50 @@
+#pragma once
+
+#include "FramePacket.h"
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+class Window;
+class Renderer;
+
+// Thread owning the GL context, drawing the packets built by the simulation thread
+// The simulation fills the next packet while the previous one is drawn, and
+// waits once MAX_FRAMES_IN_FLIGHT packets are queued or being drawn
+class RenderThread
+{
+ public:
+    // Takes the context of the window from the calling thread
+    RenderThread(Window& window, Renderer& renderer);
+
+    // Draws the queued packets then gives the context back to the calling thread
+    ~RenderThread();
+
+    // Packet to fill for the next frame, waits for the render thread to free one
+    FramePacket& acquire();
+
+    // Queue the acquired packet
+    void submit();
+
+    static const uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+
+ private:
+    void renderLoop();
+
+    Window&     _window;
+    Renderer&   _renderer;
+
+    std::array<FramePacket, MAX_FRAMES_IN_FLIGHT> _packets;
+
+    std::mutex                  _mutex;
+    std::condition_variable     _submitted;
+    std::condition_variable     _drawn;
+    uint64_t                    _submittedCount = 0;
+    uint64_t                    _drawnCount = 0;
+    bool                        _stop = false;
+
+    std::thread                 _thread;
+};
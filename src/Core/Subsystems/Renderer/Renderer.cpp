@@ -1,27 +1,37 @@
 #include "Renderer.h"
 
+#include "GpuMemory.h"
 #include "../Window/Window.h"
 #include "../ECS/ECSManager.h"
-#include "../../../Systems/CameraHandler.h"
-#include "../../../Systems/PointLightsHandler.h"
 #include "../../../Components/PointLight.h"
+#include "../../../Components/MainCamera.h"
+#include "../../../Components/PreviousTransform.h"
 
 #include <glm/gtx/string_cast.hpp>
 
+#include <algorithm>
 #include <memory>
+#include <utility>
 
+#include <cstddef>
 #include <cstdlib>
 #include <ctime>
 
 extern Window                               g_Window;
-extern std::shared_ptr<CameraHandler>       g_Camera;
-extern std::shared_ptr<PointLightsHandler>  g_PointLights;
 extern ECSManager                           g_ECSManager;
 
 uint64_t  X_DISPATCH      = 0;
 uint64_t  Y_DISPATCH      = 0;
 uint64_t  THREAD_DISPATCH = 0;
 
+// Passes of the light culling shader
+const int LIGHT_LIST_SINGLE_PASS = 0;
+const int LIGHT_LIST_COUNT_PASS  = 1;
+const int LIGHT_LIST_WRITE_PASS  = 2;
+
+// Local size of the frustum compute shader, one invocation per tile
+const uint64_t FRUSTUM_GROUP_SIZE = 16;
+
 void GLAPIENTRY MessageCallback(const GLenum source, const GLenum type, const GLuint id, const GLenum severity, const GLsizei length, const GLchar* message, const void* userParam)
 {
     if (type == GL_DEBUG_TYPE_ERROR)
@@ -37,9 +47,7 @@ void GLAPIENTRY MessageCallback(const GLenum source, const GLenum type, const GL
 // Initialize the Renderer manager
 Renderer::Renderer()
 {
-    X_DISPATCH = static_cast<uint64_t>(ceil(static_cast<float>(SCREEN_WIDTH)  / TILE_SIZE));
-    Y_DISPATCH = static_cast<uint64_t>(ceil(static_cast<float>(SCREEN_HEIGHT) / TILE_SIZE));
-    THREAD_DISPATCH = X_DISPATCH * Y_DISPATCH;
+    MemoryScope scope(MemoryTag::Renderer);
 
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_DEBUG_OUTPUT);
@@ -48,6 +56,7 @@ Renderer::Renderer()
 
     initDefaultTextures();
     initDepthBuffer();
+    initColorBuffer();
 
     //generateRandomLights();
 
@@ -55,37 +64,256 @@ Renderer::Renderer()
 
     glGenTextures(1, &_debugTexture);
     glBindTexture(GL_TEXTURE_2D, _debugTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, SCREEN_WIDTH, SCREEN_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_INT, nullptr);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
+    resizeRenderTargets();
+
+    glGenBuffers(1, &_cameraBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, _cameraBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraData), nullptr, GL_DYNAMIC_DRAW);
+    trackBuffer(MemoryTag::Renderer, _cameraBuffer, sizeof(CameraData));
+
+    _gpuTimer.init();
+
     generateRenderingQuad();
     generateSphereVAO();
 }
 
-void Renderer::init()
+void Renderer::loadWorld(const std::string& path, const bool keepGeometry)
 {
-    _camera          = g_Camera->camera();
-    _cameraTransform = g_Camera->transform();
-    computeTiledFrustum();
+    MemoryScope scope(MemoryTag::World);
+    _world.load(path, keepGeometry);
+}
+
+// Everything the frame reads from the ECS, copied so the simulation can go on
+void Renderer::buildFramePacket(FramePacket& packet, const float alpha, const float frameTime)
+{
+    const float interpolation = std::clamp(alpha, 0.0f, 1.0f);
+    const auto& mainCamera = std::as_const(g_ECSManager).singleton<MainCamera>();
+    MemoryScope scope(MemoryTag::Renderer);
+
+    // Only the position is interpolated, the view moves by its offset
+    const glm::vec3 position = glm::mix(mainCamera.previousPosition, mainCamera.transform.position, interpolation);
+    const glm::mat4 view = mainCamera.camera.view * glm::translate(glm::mat4(1.0f), mainCamera.transform.position - position);
+
+    packet.camera.view          = view;
+    packet.camera.projection    = mainCamera.camera.projection;
+    packet.camera.invProjection = mainCamera.camera.invProjection;
+    packet.camera.invView       = glm::inverse(view);
+    packet.camera.viewPos       = glm::vec4(position, 1);
+
+    packet.outputWidth      = _outputWidth;
+    packet.outputHeight     = _outputHeight;
+    packet.frameTime        = frameTime;
+    packet.targetFrameTime  = _targetFrameTime;
+
+    // No culling yet, every primitive of the world is drawn
+    packet.drawList.clear();
+    for (const auto& node : _world.getNodes())
+    {
+        if (node.gotMesh())
+        {
+            for (const auto& primitive : node.getPrimitives())
+            {
+                packet.drawList.push_back({ node.getTransform(), &primitive });
+            }
+        }
+    }
+
+    gatherLights(packet, interpolation);
+}
+
+// Camera of the packet into the uniform block read by every pass
+void Renderer::updateCameraBuffer(const CameraData& camera)
+{
+    _cameraData = camera;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, _cameraBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(CameraData), &_cameraData);
+    glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, _cameraBuffer);
+}
+
+// Tile frustums are derived from the projection and the render resolution
+void Renderer::updateTiledFrustum()
+{
+    if (_renderTargetsDirty)
+    {
+        resizeRenderTargets();
+    }
+    if (_frustumsDirty || _cameraData.projection != _frustumProjection)
+    {
+        computeTiledFrustum();
+    }
 }
 
-// Compute tiles frustum once and for all
 void Renderer::computeTiledFrustum()
 {
     _computeFrustumShader.use();
-    _computeFrustumShader.setMat4f("invProjection", g_Camera->camera().invProjection);
 
     _computeFrustumShader.set1i("tileSize", TILE_SIZE);
-    _computeFrustumShader.set1i("screenWidth", SCREEN_WIDTH);
-    _computeFrustumShader.set1i("screenHeight", SCREEN_HEIGHT);
+    _computeFrustumShader.set1i("screenWidth", _renderWidth);
+    _computeFrustumShader.set1i("screenHeight", _renderHeight);
+    _computeFrustumShader.set1i("numTilesX", X_DISPATCH);
+    _computeFrustumShader.set1i("numTilesY", Y_DISPATCH);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _frustumBuffer);
+    glDispatchCompute((X_DISPATCH + FRUSTUM_GROUP_SIZE - 1) / FRUSTUM_GROUP_SIZE, (Y_DISPATCH + FRUSTUM_GROUP_SIZE - 1) / FRUSTUM_GROUP_SIZE, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    _frustumProjection = _cameraData.projection;
+    _frustumsDirty = false;
+}
+
+// (Re)allocate everything depending on the render resolution
+void Renderer::resizeRenderTargets()
+{
+    X_DISPATCH = (_renderWidth  + TILE_SIZE - 1) / TILE_SIZE;
+    Y_DISPATCH = (_renderHeight + TILE_SIZE - 1) / TILE_SIZE;
+    THREAD_DISPATCH = X_DISPATCH * Y_DISPATCH;
+
+    // Depth pass
+    glBindTexture(GL_TEXTURE_2D, _gDepth);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, _renderWidth, _renderHeight, 0, GL_RGBA, GL_FLOAT, nullptr);
+    trackTexture(MemoryTag::Renderer, _gDepth, GL_RGBA32F, _renderWidth, _renderHeight);
+    glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, _renderWidth, _renderHeight);
+    trackRenderbuffer(MemoryTag::Renderer, rboDepth, GL_DEPTH_COMPONENT, _renderWidth, _renderHeight);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, _gDepthBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        ERROR_EXIT("Depth framebuffer not complete");
+    }
+
+    // Forward pass
+    glBindTexture(GL_TEXTURE_2D, _gColor);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, _renderWidth, _renderHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    trackTexture(MemoryTag::Renderer, _gColor, GL_RGBA8, _renderWidth, _renderHeight);
+    glBindRenderbuffer(GL_RENDERBUFFER, _colorDepthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, _renderWidth, _renderHeight);
+    trackRenderbuffer(MemoryTag::Renderer, _colorDepthBuffer, GL_DEPTH_COMPONENT, _renderWidth, _renderHeight);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, _colorBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        ERROR_EXIT("Color framebuffer not complete");
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // Light culling
+    glBindTexture(GL_TEXTURE_RECTANGLE, _gLightGrid);
+    glTexImage2D(GL_TEXTURE_RECTANGLE, 0, GL_RG32UI, _renderWidth, _renderHeight, 0, GL_RG_INTEGER, GL_UNSIGNED_INT, nullptr);
+    trackTexture(MemoryTag::Renderer, _gLightGrid, GL_RG32UI, _renderWidth, _renderHeight);
+    glBindTexture(GL_TEXTURE_2D, _debugTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, _renderWidth, _renderHeight, 0, GL_RGBA, GL_UNSIGNED_INT, nullptr);
+    trackTexture(MemoryTag::Renderer, _debugTexture, GL_RGBA32F, _renderWidth, _renderHeight);
 
-    glGenBuffers(1, &_frustumBuffer);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, _frustumBuffer);
     glBufferData(GL_SHADER_STORAGE_BUFFER, THREAD_DISPATCH * sizeof(Frustum), nullptr, GL_STATIC_DRAW);
-     
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _frustumBuffer);
-    glDispatchCompute(ceil(static_cast<float>(X_DISPATCH) / TILE_SIZE), ceil(static_cast<float>(Y_DISPATCH) / TILE_SIZE), 1);
+    trackBuffer(MemoryTag::Renderer, _frustumBuffer, THREAD_DISPATCH * sizeof(Frustum));
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _tileLightOffsetsBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, THREAD_DISPATCH * sizeof(uint32_t), nullptr, GL_DYNAMIC_COPY);
+    trackBuffer(MemoryTag::Renderer, _tileLightOffsetsBuffer, THREAD_DISPATCH * sizeof(uint32_t));
+
+    // The compact list fits itself to the light coverage
+    if (_lightListLayout == LightListLayout::PerTileCap)
+    {
+        resizeLightIndexList(THREAD_DISPATCH * MAX_LIGHTS_PER_TILE);
+    }
+
+    _renderTargetsDirty = false;
+    _frustumsDirty = true;
+
+    OK("Render resolution " << _renderWidth << "x" << _renderHeight);
+}
+
+void Renderer::setOutputResolution(const uint32_t width, const uint32_t height)
+{
+    // Minimized window
+    if (width == 0 || height == 0)
+    {
+        return;
+    }
+
+    _outputWidth = width;
+    _outputHeight = height;
+}
+
+// Window size of the drawn packet
+void Renderer::resizeFrame(const uint32_t width, const uint32_t height)
+{
+    if (width != _frameWidth || height != _frameHeight)
+    {
+        _frameWidth = width;
+        _frameHeight = height;
+        setRenderScale(_renderScale);
+    }
+}
+
+void Renderer::setRenderScale(const float scale)
+{
+    _renderScale = std::clamp(scale, MIN_RENDER_SCALE, 1.0f);
+
+    const uint32_t width  = std::max(static_cast<uint32_t>(_frameWidth  * _renderScale), uint32_t{1});
+    const uint32_t height = std::max(static_cast<uint32_t>(_frameHeight * _renderScale), uint32_t{1});
+    if (width != _renderWidth || height != _renderHeight)
+    {
+        _renderWidth = width;
+        _renderHeight = height;
+        _renderTargetsDirty = true;
+    }
+}
+
+void Renderer::setDynamicResolution(const bool enabled, const float targetFrameTime)
+{
+    _targetFrameTime = enabled ? targetFrameTime : 0.0f;
+}
+
+// Adjust the render scale to hold the target frame time of the packet
+void Renderer::updateDynamicResolution(const float frameTime, const float targetFrameTime)
+{
+    // A new target starts over from the full resolution
+    if (targetFrameTime != _drawnTargetFrameTime)
+    {
+        _drawnTargetFrameTime = targetFrameTime;
+        _smoothedFrameTime = targetFrameTime;
+        _framesSinceScaleChange = 0;
+        setRenderScale(1.0f);
+    }
+
+    if (_drawnTargetFrameTime <= 0.0f)
+    {
+        return;
+    }
+
+    // Smoothed so a single spike does not resize the targets
+    _smoothedFrameTime = 0.9f * _smoothedFrameTime + 0.1f * frameTime;
+    if (++_framesSinceScaleChange < 30)
+    {
+        return;
+    }
+
+    float scale = _renderScale;
+    if (_smoothedFrameTime > _drawnTargetFrameTime * 1.05f)
+    {
+        scale -= 0.05f;
+    }
+    else if (_smoothedFrameTime < _drawnTargetFrameTime * 0.85f)
+    {
+        scale += 0.05f;
+    }
+
+    if (std::clamp(scale, MIN_RENDER_SCALE, 1.0f) != _renderScale)
+    {
+        setRenderScale(scale);
+        _framesSinceScaleChange = 0;
+    }
+}
+
+float Renderer::aspectRatio() const
+{
+    return static_cast<float>(_outputWidth) / static_cast<float>(_outputHeight);
 }
 
 void Renderer::initDefaultTextures()
@@ -106,7 +334,6 @@ void Renderer::initDepthBuffer()
 
     glGenTextures(1, &_gDepth);
     glBindTexture(GL_TEXTURE_2D, _gDepth);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, SCREEN_WIDTH, SCREEN_HEIGHT, 0, GL_RGBA, GL_FLOAT, nullptr);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _gDepth, 0);
@@ -114,58 +341,233 @@ void Renderer::initDepthBuffer()
     const GLuint attachments[1] = { GL_COLOR_ATTACHMENT0 };
     glDrawBuffers(1, attachments);
 
-    GLuint rboDepth;
     glGenRenderbuffers(1, &rboDepth);
     glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, SCREEN_WIDTH, SCREEN_HEIGHT);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-    {
-        ERROR_EXIT("Depth framebuffer not complete");
-    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// Forward pass target at the render resolution, scaled to the window when presented
+void Renderer::initColorBuffer()
+{
+    glGenFramebuffers(1, &_colorBuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, _colorBuffer);
+
+    glGenTextures(1, &_gColor);
+    glBindTexture(GL_TEXTURE_2D, _gColor);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _gColor, 0);
+
+    glGenRenderbuffers(1, &_colorDepthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, _colorDepthBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _colorDepthBuffer);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void Renderer::initForwardPass()
 {
     glGenBuffers(1, &_lightsBuffer);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _lightsBuffer);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, NR_LIGHTS * sizeof(PointLight), nullptr, GL_STATIC_DRAW);
+    allocateLightBuffers();
 
     glGenBuffers(1, &_lightIndexCounterBuffer);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, _lightIndexCounterBuffer);
     glBufferData(GL_SHADER_STORAGE_BUFFER, 1 * sizeof(uint32_t), nullptr, GL_STATIC_DRAW);
+    trackBuffer(MemoryTag::Renderer, _lightIndexCounterBuffer, 1 * sizeof(uint32_t));
 
+    // Sized with the render resolution
+    glGenBuffers(1, &_frustumBuffer);
     glGenBuffers(1, &_lightIndexListBuffer);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _lightIndexListBuffer);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, THREAD_DISPATCH * MAX_LIGHTS_PER_TILE * sizeof(uint32_t), nullptr, GL_STATIC_DRAW);
+    glGenBuffers(1, &_tileLightOffsetsBuffer);
+
+    glGenBuffers(1, &_lightCullingStatsBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _lightCullingStatsBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(LightCullingStats), nullptr, GL_DYNAMIC_COPY);
+    trackBuffer(MemoryTag::Renderer, _lightCullingStatsBuffer, sizeof(LightCullingStats));
+
+    glGenBuffers(1, &_lightCullingStatsReadbackBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _lightCullingStatsReadbackBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, sizeof(LightCullingStats), nullptr, GL_STREAM_READ);
+    trackBuffer(MemoryTag::Renderer, _lightCullingStatsReadbackBuffer, sizeof(LightCullingStats));
 
     glGenTextures(1, &_gLightGrid);
     glBindTexture(GL_TEXTURE_RECTANGLE, _gLightGrid);
-    glTexImage2D(GL_TEXTURE_RECTANGLE, 0, GL_RG32UI, SCREEN_WIDTH, SCREEN_HEIGHT, 0, GL_RG_INTEGER, GL_UNSIGNED_INT, nullptr);
     glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 }
 
-// Draw the frame by executing the queues while staying synchronised
-void Renderer::drawFrame()
+// Everything sized with the light capacity, the lights are uploaded again
+void Renderer::allocateLightBuffers()
+{
+    MemoryScope scope(MemoryTag::Renderer);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _lightsBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, std::max(_maxLights, uint64_t{1}) * sizeof(PointLight), nullptr, GL_DYNAMIC_DRAW);
+    trackBuffer(MemoryTag::Renderer, _lightsBuffer, std::max(_maxLights, uint64_t{1}) * sizeof(PointLight));
+    _lights.clear();
+    _lights.reserve(_maxLights);
+    _movingLights.clear();
+    _movingLights.reserve(_maxLights);
+    _drawnLights.clear();
+    _drawnLights.reserve(_maxLights);
+    _lightGrid.init(_maxLights);
+    _lightBVH.init(_maxLights);
+
+    _uploadedLightCount = 0;
+    _lightCullingDirty = true;
+}
+
+void Renderer::setMaxLights(const uint64_t maxLights)
+{
+    if (maxLights != _maxLights)
+    {
+        _maxLights = maxLights;
+        allocateLightBuffers();
+    }
+}
+
+uint64_t Renderer::maxLights() const
 {
-    _camera          = g_Camera->camera();
-    _cameraTransform = g_Camera->transform();
+    return _maxLights;
+}
+
+void Renderer::setGpuTiming(const bool enabled)
+{
+    _gpuTimer.setEnabled(enabled);
+}
+
+// Pass timings of the frames finished on the GPU, or of every drawn frame when waiting
+const std::vector<PassTimings>& Renderer::takePassTimings(const bool wait)
+{
+    if (wait)
+    {
+        _gpuTimer.flush();
+    }
+    return _gpuTimer.takeResults();
+}
+
+const char* lightCullingName(const LightCulling lightCulling)
+{
+    switch (lightCulling)
+    {
+        case LightCulling::Grid:
+            return "grid";
+        case LightCulling::BVH:
+            return "bvh";
+        default:
+            return "unknown";
+    }
+}
+
+const char* lightListLayoutName(const LightListLayout lightListLayout)
+{
+    switch (lightListLayout)
+    {
+        case LightListLayout::PerTileCap:
+            return "per-tile-cap";
+        case LightListLayout::Compact:
+            return "compact";
+        default:
+            return "unknown";
+    }
+}
 
-    copyLightDataToGPU();
+void Renderer::setLightCulling(const LightCulling lightCulling)
+{
+    // The new structure has to be built even if no light changed
+    _lightCullingDirty |= _lightCulling != lightCulling;
+    _lightCulling = lightCulling;
+}
+
+void Renderer::setLightListLayout(const LightListLayout lightListLayout)
+{
+    _lightListLayout = lightListLayout;
+    if (_lightListLayout == LightListLayout::PerTileCap)
+    {
+        resizeLightIndexList(std::max(_lightIndexListCapacity, THREAD_DISPATCH * MAX_LIGHTS_PER_TILE));
+    }
+}
+
+// 2.5D culling of the lights lying in the depth gaps of the tiles
+void Renderer::setDepthMaskCulling(const bool enabled)
+{
+    _depthMaskCulling = enabled;
+}
+
+const LightCullingStats& Renderer::lightCullingStats() const
+{
+    return _lightCullingStats;
+}
+
+void Renderer::resizeLightIndexList(const uint64_t capacity)
+{
+    _lightIndexListCapacity = capacity;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _lightIndexListBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, std::max(capacity, uint64_t{1}) * sizeof(uint32_t), nullptr, GL_DYNAMIC_COPY);
+    trackBuffer(MemoryTag::Renderer, _lightIndexListBuffer, std::max(capacity, uint64_t{1}) * sizeof(uint32_t));
+}
+
+// Draw the frame of a packet by executing the queues while staying synchronised
+void Renderer::drawFrame(const FramePacket& packet)
+{
+    MemoryScope scope(MemoryTag::Renderer);
+    _gpuTimer.beginFrame();
+
+    resizeFrame(packet.outputWidth, packet.outputHeight);
+    updateDynamicResolution(packet.frameTime, packet.targetFrameTime);
+    updateCameraBuffer(packet.camera);
+
+    updateTiledFrustum();
+    _gpuTimer.beginPass(RenderPass::LightUpload);
+    copyLightDataToGPU(packet);
     
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     
-    depthPass();
+    glViewport(0, 0, _renderWidth, _renderHeight);
+    _gpuTimer.beginPass(RenderPass::Depth);
+    depthPass(packet.drawList);
+
+    _gpuTimer.beginPass(RenderPass::LightCulling);
+    lightCullingPass();
+    
+    //debugPass();
+
+    _gpuTimer.beginPass(RenderPass::Forward);
+    tiledForwardPass(packet.drawList);
+    drawTextureToScreen(_debugTexture);
+
+    // Scale the frame to the window
+    _gpuTimer.beginPass(RenderPass::Present);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, _frameWidth, _frameHeight);
+    glDisable(GL_DEPTH_TEST);
+    drawTextureToScreen(_gColor);
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+
+    glBindVertexArray(0);
+    _gpuTimer.endFrame();
+}
+
+void Renderer::lightCullingPass()
+{
+    // The list is only resized in this pass, before the passes writing it and the forward pass reading it
+    readLightCullingStats();
+    fitLightIndexList();
 
     _tiledForwardShader.use();
-    _tiledForwardShader.setMat4f("invProjection", _camera.invProjection);
+    _tiledForwardShader.set1i("cullingMode",      static_cast<int>(_lightCulling));
+    _tiledForwardShader.set1i("depthMaskCulling", _depthMaskCulling);
+    _lightGrid.setUniforms(_tiledForwardShader);
+    _lightBVH.setUniforms(_tiledForwardShader);
 
-    _tiledForwardShader.set1i("numLights",      NR_LIGHTS);
+    _tiledForwardShader.set1i("numLights",      _lightCount);
     _tiledForwardShader.set1i("tileSize",       TILE_SIZE);
-    _tiledForwardShader.set1i("screenWidth",    SCREEN_WIDTH);
-    _tiledForwardShader.set1i("screenHeight",   SCREEN_HEIGHT);
+    _tiledForwardShader.set1i("screenWidth",    _renderWidth);
+    _tiledForwardShader.set1i("screenHeight",   _renderHeight);
+    _tiledForwardShader.set1i("lightIndexListCapacity", _lightIndexListCapacity);
 
     glBindImageTexture(                         0, _gDepth,             0, GL_FALSE, 0, GL_READ_ONLY,  GL_RGBA32F);
     glBindImageTexture(                         1, _gLightGrid,         0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG32UI);
@@ -174,18 +576,117 @@ void Renderer::drawFrame()
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER,  4, _lightIndexListBuffer);
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER,  5, _lightsBuffer);
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER,  6, _frustumBuffer);
-    glDispatchCompute(X_DISPATCH, Y_DISPATCH, 1);
-    
-    //debugPass();
+    _lightGrid.bind(7, 8);
+    _lightBVH.bind(9, 10);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 11, _tileLightOffsetsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 12, _lightCullingStatsBuffer);
 
-    tiledForwardPass();
-    drawTextureToScreen(_debugTexture);
+    // Reset the counters of the frame
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _lightIndexCounterBuffer);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _lightCullingStatsBuffer);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
 
-    glBindVertexArray(0);
+    switch (_lightListLayout)
+    {
+        case LightListLayout::PerTileCap:
+            _tiledForwardShader.set1i("lightListPass", LIGHT_LIST_SINGLE_PASS);
+            glDispatchCompute(X_DISPATCH, Y_DISPATCH, 1);
+            break;
+        case LightListLayout::Compact:
+            // Count the lights of every tile
+            _tiledForwardShader.set1i("lightListPass", LIGHT_LIST_COUNT_PASS);
+            glDispatchCompute(X_DISPATCH, Y_DISPATCH, 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+            // Offsets of the tiles into the light index list, the total goes to the statistics
+            _prefixSumShader.use();
+            _prefixSumShader.set1i("count", THREAD_DISPATCH);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _tileLightOffsetsBuffer);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, _lightCullingStatsBuffer);
+            glDispatchCompute(1, 1, 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            growLightIndexList();
+
+            // Write the lights of every tile at their offset
+            _tiledForwardShader.use();
+            _tiledForwardShader.set1i("lightListPass", LIGHT_LIST_WRITE_PASS);
+            _tiledForwardShader.set1i("lightIndexListCapacity", _lightIndexListCapacity);
+            glDispatchCompute(X_DISPATCH, Y_DISPATCH, 1);
+            break;
+    }
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    requestLightCullingStats();
+}
+
+// Read back the statistics of a previous frame without waiting for the GPU
+void Renderer::readLightCullingStats()
+{
+    if (_lightCullingStatsFence == nullptr || glClientWaitSync(_lightCullingStatsFence, 0, 0) == GL_TIMEOUT_EXPIRED)
+    {
+        return;
+    }
+    glDeleteSync(_lightCullingStatsFence);
+    _lightCullingStatsFence = nullptr;
+
+    glBindBuffer(GL_COPY_READ_BUFFER, _lightCullingStatsReadbackBuffer);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(LightCullingStats), &_lightCullingStats);
+}
+
+// Copy the statistics of this frame for a later read back
+void Renderer::requestLightCullingStats()
+{
+    if (_lightCullingStatsFence != nullptr)
+    {
+        return;
+    }
+
+    glBindBuffer(GL_COPY_READ_BUFFER,  _lightCullingStatsBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _lightCullingStatsReadbackBuffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, sizeof(LightCullingStats));
+    _lightCullingStatsFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 }
 
-void Renderer::tiledForwardPass()
+// Shrink the compact list once the coverage counted by a previous frame falls under an eighth
+// of its capacity, the statistics lag a few frames so growing is left to growLightIndexList
+void Renderer::fitLightIndexList()
 {
+    if (_lightListLayout != LightListLayout::Compact)
+    {
+        return;
+    }
+
+    const uint64_t needed = std::max(uint64_t{_lightCullingStats.totalLightIndices}, THREAD_DISPATCH);
+    if (needed * 8 < _lightIndexListCapacity)
+    {
+        resizeLightIndexList(needed * 2);
+    }
+}
+
+// Grow the compact list to the total of this frame before the write pass
+// Reading the total back waits for the count pass and the prefix sum
+void Renderer::growLightIndexList()
+{
+    uint32_t totalLightIndices = 0;
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_COPY_READ_BUFFER, _lightCullingStatsBuffer);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, offsetof(LightCullingStats, totalLightIndices), sizeof(uint32_t), &totalLightIndices);
+
+    if (totalLightIndices > _lightIndexListCapacity)
+    {
+        resizeLightIndexList(uint64_t{totalLightIndices} * 2);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, _lightIndexListBuffer);
+    }
+}
+
+void Renderer::tiledForwardPass(const std::vector<DrawItem>& drawList)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, _colorBuffer);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
     _tiledForwardPassShader.use();
     _tiledForwardPassShader.set1i("lightGrid", 0);
     _tiledForwardPassShader.set1i("albedoMap", 1);
@@ -194,9 +695,6 @@ void Renderer::tiledForwardPass()
     _tiledForwardPassShader.set1i("normalMap", 4);
     _tiledForwardPassShader.set1i("occlusionMap", 5);
 
-    _tiledForwardPassShader.setMat4f("projection", _camera.projection);
-    _tiledForwardPassShader.setMat4f("view", _camera.view);
-    _tiledForwardPassShader.set3f("viewPos", _cameraTransform.position);
     
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _lightIndexListBuffer);
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, _lightsBuffer);
@@ -205,137 +703,248 @@ void Renderer::tiledForwardPass()
     glBindTexture(GL_TEXTURE_RECTANGLE, _gLightGrid);
 
     const auto& textures = _world.getTextures();
-    for (const auto& node : _world.getNodes())
+    for (const auto& item : drawList)
     {
-        if (node.gotMesh())
+        const Primitive& primitive = *item.primitive;
+        _tiledForwardPassShader.setMat4f("model", item.model);
+
+        // Albedo texture
+        glActiveTexture(GL_TEXTURE1);
+        if (primitive.material.hasAlbedoTexture)
         {
-            _tiledForwardPassShader.setMat4f("model", node.getTransform());
+            glBindTexture(GL_TEXTURE_2D, textures[primitive.material.albedoTexture].id);
+        }
+        else
+        {
+            // Using default texture
+            glBindTexture(GL_TEXTURE_2D, _defaultAlbedoTexture);
+            const uint8_t albedo[3] = { 255 * primitive.material.albedoFactor.x, 255 * primitive.material.albedoFactor.y, 255 * primitive.material.albedoFactor.z };
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, &albedo);
+        }
 
-            for (const auto& primitive : node.getPrimitives())
-            {
-                // Albedo texture
-                glActiveTexture(GL_TEXTURE1);
-                if (primitive.material.hasAlbedoTexture)
-                {
-                    glBindTexture(GL_TEXTURE_2D, textures[primitive.material.albedoTexture].id);
-                }
-                else
-                {
-                    // Using default texture
-                    glBindTexture(GL_TEXTURE_2D, _defaultAlbedoTexture);
-                    const uint8_t albedo[3] = { 255 * primitive.material.albedoFactor.x, 255 * primitive.material.albedoFactor.y, 255 * primitive.material.albedoFactor.z };
-                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, &albedo);
-                }
-
-                // MetallicRoughness texture
-                glActiveTexture(GL_TEXTURE2);
-                if (primitive.material.hasMetallicRoughnessTexture)
-                {
-                    glBindTexture(GL_TEXTURE_2D, textures[primitive.material.metallicRoughnessTexture].id);
-                }
-                else
-                {
-                    glBindTexture(GL_TEXTURE_2D, _defaultMetallicRoughnessTexture);
-                    const float metallic[4] = { 0, primitive.material.roughnessFactor, primitive.material.metallicFactor, 0 };
-                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, 1, 1, 0, GL_RGBA, GL_FLOAT, &metallic);
-                }
-
-                // Emissive texture
-                glActiveTexture(GL_TEXTURE3);
-                if (primitive.material.hasEmissiveTexture)
-                {
-                    glBindTexture(GL_TEXTURE_2D, textures[primitive.material.emissiveTexture].id);
-                }
-                else
-                {
-                    glBindTexture(GL_TEXTURE_2D, _defaultEmissiveTexture);
-                    const uint8_t emissive[3] = { 255*primitive.material.emissiveFactor.x, 255 * primitive.material.emissiveFactor.y, 255 * primitive.material.emissiveFactor.z };
-                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &emissive);
-                }
-
-                // Normal texture
-                glActiveTexture(GL_TEXTURE4);
-                if (primitive.material.hasNormalTexture)
-                {
-                    glBindTexture(GL_TEXTURE_2D, textures[primitive.material.normalTexture].id);
-                }
-                else
-                {
-                    glBindTexture(GL_TEXTURE_2D, _defaultNormalTexture);
-                    const uint8_t normal[3] = { 128, 128, 255 };
-                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &normal);
-                }
-
-                // Occlusion texture
-                glActiveTexture(GL_TEXTURE5);
-                if (primitive.material.hasOcclusionTexture)
-                {
-                    glBindTexture(GL_TEXTURE_2D, textures[primitive.material.occlusionTexture].id);
-                }
-                else
-                {
-                    glBindTexture(GL_TEXTURE_2D, _defaultOcclusionTexture);
-                    const uint8_t occlusion[3] = { 255, 0, 0 };
-                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &occlusion);
-                }
-
-                glBindVertexArray(primitive.VAO);
-                glDrawElements(GL_TRIANGLES, primitive.indices.size(), GL_UNSIGNED_INT, 0);
-            }
+        // MetallicRoughness texture
+        glActiveTexture(GL_TEXTURE2);
+        if (primitive.material.hasMetallicRoughnessTexture)
+        {
+            glBindTexture(GL_TEXTURE_2D, textures[primitive.material.metallicRoughnessTexture].id);
+        }
+        else
+        {
+            glBindTexture(GL_TEXTURE_2D, _defaultMetallicRoughnessTexture);
+            const float metallic[4] = { 0, primitive.material.roughnessFactor, primitive.material.metallicFactor, 0 };
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, 1, 1, 0, GL_RGBA, GL_FLOAT, &metallic);
+        }
+
+        // Emissive texture
+        glActiveTexture(GL_TEXTURE3);
+        if (primitive.material.hasEmissiveTexture)
+        {
+            glBindTexture(GL_TEXTURE_2D, textures[primitive.material.emissiveTexture].id);
+        }
+        else
+        {
+            glBindTexture(GL_TEXTURE_2D, _defaultEmissiveTexture);
+            const uint8_t emissive[3] = { 255*primitive.material.emissiveFactor.x, 255 * primitive.material.emissiveFactor.y, 255 * primitive.material.emissiveFactor.z };
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &emissive);
+        }
+
+        // Normal texture
+        glActiveTexture(GL_TEXTURE4);
+        if (primitive.material.hasNormalTexture)
+        {
+            glBindTexture(GL_TEXTURE_2D, textures[primitive.material.normalTexture].id);
+        }
+        else
+        {
+            glBindTexture(GL_TEXTURE_2D, _defaultNormalTexture);
+            const uint8_t normal[3] = { 128, 128, 255 };
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &normal);
         }
+
+        // Occlusion texture
+        glActiveTexture(GL_TEXTURE5);
+        if (primitive.material.hasOcclusionTexture)
+        {
+            glBindTexture(GL_TEXTURE_2D, textures[primitive.material.occlusionTexture].id);
+        }
+        else
+        {
+            glBindTexture(GL_TEXTURE_2D, _defaultOcclusionTexture);
+            const uint8_t occlusion[3] = { 255, 0, 0 };
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &occlusion);
+        }
+
+        glBindVertexArray(primitive.VAO);
+        glDrawElements(GL_TRIANGLES, primitive.indexCount, primitive.indexType, 0);
     }
-        
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
-void Renderer::depthPass()
+void Renderer::depthPass(const std::vector<DrawItem>& drawList)
 {
     glBindFramebuffer(GL_FRAMEBUFFER, _gDepthBuffer);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     _depthShader.use();
-    _depthShader.setMat4f("projection", _camera.projection);
-    _depthShader.setMat4f("view", _camera.view);
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, _gDepth);
 
-    for (const auto& node : _world.getNodes())
+    for (const auto& item : drawList)
     {
-        if (node.gotMesh())
+        _depthShader.setMat4f("model", item.model);
+        glBindVertexArray(item.primitive->VAO);
+        glDrawElements(GL_TRIANGLES, item.primitive->indexCount, item.primitive->indexType, 0);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// Interpolated lights, only the ranges changed since the previous packet are copied into it
+// A light changed when its PointLight or Transform was written since, or when it was still
+// between two different transforms as its position then follows alpha. The PreviousTransform
+// is rewritten from the Transform every step, its version says nothing
+void Renderer::gatherLights(FramePacket& packet, const float alpha)
+{
+    const ECSManager& ecs = g_ECSManager;
+    const ComponentArray<PointLight>& pointLights = ecs.getComponentArray<PointLight>();
+    const ComponentArray<Transform>& transforms = ecs.getComponentArray<Transform>();
+    const ComponentArray<PreviousTransform>& previousTransforms = ecs.getComponentArray<PreviousTransform>();
+
+    // The dense indices moved, every light may have moved too
+    const std::array<uint64_t, 3> structureVersions =
+    {
+        pointLights.structureVersion(),
+        transforms.structureVersion(),
+        previousTransforms.structureVersion(),
+    };
+    if (structureVersions != _lightStructureVersions)
+    {
+        _lightStructureVersions = structureVersions;
+        _uploadedLightCount = 0;
+        gatherLightRows();
+    }
+
+    const uint32_t lightCount = static_cast<uint32_t>(std::min<uint64_t>(_lightRows.size(), _maxLights));
+    const bool countChanged = lightCount != _lights.size();
+    _lights.resize(lightCount);
+    _movingLights.resize(lightCount);
+
+    // Gather the dirty lights into ranges, merging the close ones
+    auto& dirtyLightRanges = packet.dirtyLightRanges;
+    dirtyLightRanges.clear();
+    const auto update = [&](const uint32_t i, const PointLight& light, const glm::vec3& position)
+    {
+        PointLight& sent = _lights[i];
+        if (i < _uploadedLightCount && sent.color == light.color && sent.range == light.range && glm::vec3(sent.position) == position)
         {
-            _depthShader.setMat4f("model", node.getTransform());
+            return;
+        }
+        sent.color = light.color;
+        sent.range = light.range;
+        sent.position = glm::vec4(position, 1);
 
-            for (const auto& primitive : node.getPrimitives())
-            {
-                glBindVertexArray(primitive.VAO);
-                glDrawElements(GL_TRIANGLES, primitive.indices.size(), GL_UNSIGNED_INT, 0);
-            }
+        if (!dirtyLightRanges.empty() && i - dirtyLightRanges.back().y <= LIGHT_UPLOAD_GAP)
+        {
+            dirtyLightRanges.back().y = i + 1;
+        }
+        else
+        {
+            dirtyLightRanges.emplace_back(i, i + 1);
+        }
+    };
+
+    // Field-wise, the rows follow the packed positions
+    const std::span<const PointLight> lights = pointLights.components();
+    const std::span<const glm::vec3> positions = transforms.storage().field<0>();
+    const std::span<const PreviousTransform> previous = previousTransforms.components();
+    const std::span<const uint64_t> lightVersions = pointLights.versions();
+    const std::span<const uint64_t> transformVersions = transforms.versions();
+    for (uint32_t i = 0; i < lightCount; ++i)
+    {
+        const glm::uvec3 row = _lightRows[i];
+        if (i < _uploadedLightCount && !_movingLights[i] &&
+            lightVersions[row.x] <= _lightsUploadTick && transformVersions[row.y] <= _lightsUploadTick)
+        {
+            continue;
+        }
+
+        if (row.z == ComponentArray<PreviousTransform>::INVALID_INDEX)
+        {
+            _movingLights[i] = false;
+            update(i, lights[row.x], positions[row.y]);
+        }
+        else
+        {
+            _movingLights[i] = previous[row.z].position != positions[row.y];
+            update(i, lights[row.x], glm::mix(previous[row.z].position, positions[row.y], alpha));
         }
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // Only the changed lights travel, packed in the order of their ranges
+    packet.lights.clear();
+    for (const auto& range : dirtyLightRanges)
+    {
+        packet.lights.insert(packet.lights.end(), _lights.begin() + range.x, _lights.begin() + range.y);
+    }
+    packet.lightCount = lightCount;
+    packet.lightsChanged = !dirtyLightRanges.empty() || countChanged;
+
+    _lightsUploadTick = ecs.changeTick();
+    _uploadedLightCount = lightCount;
 }
 
-void Renderer::copyLightDataToGPU()
+// Dense indices of the point light, transform and previous transform of each
+// sent light, sorted by transform so the positions are read in order
+void Renderer::gatherLightRows()
 {
-    glBindBuffer(GL_ARRAY_BUFFER, _lightsBuffer);
-    const auto& pointLights = g_PointLights->pointLights();
-    
-    PointLight* ptr = reinterpret_cast<PointLight*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, pointLights.size() * sizeof(PointLight), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    const ECSManager& ecs = g_ECSManager;
+    const ComponentArray<PointLight>& pointLights = ecs.getComponentArray<PointLight>();
+    const ComponentArray<Transform>& transforms = ecs.getComponentArray<Transform>();
+    const ComponentArray<PreviousTransform>& previousTransforms = ecs.getComponentArray<PreviousTransform>();
 
-    uint32_t i = 0;
-    for (const auto& entity : pointLights)
+    _lightRows.clear();
+    const std::span<const Entity> entities = pointLights.entities();
+    for (uint32_t i = 0; i < entities.size(); ++i)
     {
-        auto& pointLight = g_ECSManager.getComponent<PointLight>(entity);
-        auto& pointLightTransform = g_ECSManager.getComponent<Transform>(entity);
+        const uint32_t transform = transforms.find(entities[i]);
+        if (transform != ComponentArray<Transform>::INVALID_INDEX)
+        {
+            _lightRows.emplace_back(i, transform, previousTransforms.find(entities[i]));
+        }
+    }
+    std::sort(_lightRows.begin(), _lightRows.end(), [](const glm::uvec3& a, const glm::uvec3& b) { return a.y < b.y; });
+}
 
-        ptr[i].color = pointLight.color;
-        ptr[i].range = pointLight.range;
-        ptr[i].position = glm::vec4(pointLightTransform.position, 1);
-        ptr[i].positionVS = _camera.view * glm::vec4(pointLightTransform.position, 1);
+// Apply the lights changed since the previous packet, on the GPU and to the lights of the culling
+// Packets are drawn in order so the ranges apply to the lights of the last one
+void Renderer::copyLightDataToGPU(const FramePacket& packet)
+{
+    _drawnLights.resize(packet.lightCount);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _lightsBuffer);
+    const PointLight* lights = packet.lights.data();
+    for (const auto& range : packet.dirtyLightRanges)
+    {
+        const uint32_t count = range.y - range.x;
+        std::copy(lights, lights + count, _drawnLights.begin() + range.x);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, range.x * sizeof(PointLight), count * sizeof(PointLight), lights);
+        lights += count;
+    }
+    _lightCount = packet.lightCount;
 
-        i++;
+    // Static lights keep their acceleration structure
+    if (!packet.lightsChanged && !_lightCullingDirty)
+    {
+        return;
+    }
+    _lightCullingDirty = false;
+
+    // Build the light culling acceleration structure
+    switch (_lightCulling)
+    {
+        case LightCulling::Grid:
+            _lightGrid.build(_drawnLights);
+            break;
+        case LightCulling::BVH:
+            _lightBVH.build(_drawnLights, _lightsBuffer);
+            break;
     }
-        
-    glUnmapBuffer(GL_ARRAY_BUFFER);
 }
 
 void Renderer::generateRenderingQuad()
@@ -352,6 +961,7 @@ void Renderer::generateRenderingQuad()
     glBindVertexArray(_quadVAO);
     glBindBuffer(GL_ARRAY_BUFFER, _quadVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
+    trackBuffer(MemoryTag::Renderer, _quadVBO, sizeof(quadVertices));
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(1);
@@ -361,8 +971,6 @@ void Renderer::generateRenderingQuad()
 void Renderer::debugPass()
 {
     _lightSpheresShader.use();
-    _lightSpheresShader.setMat4f("projection", _camera.projection);
-    _lightSpheresShader.setMat4f("view", _camera.view);
     
     /*
     for (uint16_t i = 0; i < pointLights.size(); ++i)
@@ -444,11 +1052,13 @@ void Renderer::generateSphereVAO()
 
     glBindBuffer(GL_ARRAY_BUFFER, _sphereVBO);
     glBufferData(GL_ARRAY_BUFFER, sphereVertices.size()*sizeof(GLfloat), sphereVertices.data(), GL_STATIC_DRAW);
+    trackBuffer(MemoryTag::Renderer, _sphereVBO, sphereVertices.size() * sizeof(GLfloat));
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3*sizeof(GLfloat), (GLvoid*)nullptr);
     glEnableVertexAttribArray(0);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _sphereEBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sphereIndices.size()*sizeof(GLuint), sphereIndices.data(), GL_STATIC_DRAW);
+    trackBuffer(MemoryTag::Renderer, _sphereEBO, sphereIndices.size() * sizeof(GLuint));
 
     glBindVertexArray(0);
 }
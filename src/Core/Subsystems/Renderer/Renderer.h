@@ -22,8 +22,14 @@
 
 #include "world/World.h"
 #include "Shader.h"
+#include "LightGrid.h"
+#include "LightBVH.h"
+#include "LightCulling.h"
+#include "GpuTimer.h"
+#include "FramePacket.h"
 #include "../../../Components/Camera.h"
 #include "../../../Components/Transform.h"
+#include "../../../Components/PointLight.h"
 
 struct Frustum
 {
@@ -31,38 +37,102 @@ struct Frustum
     float       d[4]; // Distance to origins
 };
 
+// The frame packets are built on the simulation thread and drawn on the thread
+// owning the context, the other settings belong to the latter
 class Renderer
 {
  public:
     Renderer();
-    void init();
-    void drawFrame();
+    void loadWorld(const std::string& path, const bool keepGeometry);
+
+    // Simulation thread, snapshot of the state at alpha between the last two simulation steps
+    void buildFramePacket(FramePacket& packet, const float alpha, const float frameTime);
+
+    void drawFrame(const FramePacket& packet);
+    void setLightCulling(const LightCulling lightCulling);
+    void setLightListLayout(const LightListLayout lightListLayout);
+    void setDepthMaskCulling(const bool enabled);
+    const LightCullingStats& lightCullingStats() const;
+
+    // Simulation thread, the window size and frame time target sent with the next packets
+    void setOutputResolution(const uint32_t width, const uint32_t height);
+    void setDynamicResolution(const bool enabled, const float targetFrameTime);
+    float aspectRatio() const;
+
+    void setRenderScale(const float scale);
+
+    // Lights uploaded at most, the others are ignored
+    // Reallocates the light buffers, called before the render thread starts
+    void setMaxLights(const uint64_t maxLights);
+    uint64_t maxLights() const;
+
+    // GPU time of the passes, off by default
+    void setGpuTiming(const bool enabled);
+    const std::vector<PassTimings>& takePassTimings(const bool wait);
 
     const uint64_t  TILE_SIZE = 16;
-    const uint64_t  NR_LIGHTS = 32768;
     const uint64_t  MAX_LIGHTS_PER_TILE = 256;
-    const uint64_t  SCREEN_WIDTH = 1280;
-    const uint64_t  SCREEN_HEIGHT = 720;
+    const float     MIN_RENDER_SCALE = 0.25f;
 
  private:
     void initDefaultTextures();
     void initDepthBuffer();
+    void initColorBuffer();
     void initForwardPass();
+    void allocateLightBuffers();
+    void resizeRenderTargets();
+    void resizeFrame(const uint32_t width, const uint32_t height);
+    void updateDynamicResolution(const float frameTime, const float targetFrameTime);
 
+    void updateTiledFrustum();
     void computeTiledFrustum();
 
-    void depthPass();
-    void copyLightDataToGPU();
+    void depthPass(const std::vector<DrawItem>& drawList);
+    void lightCullingPass();
+    void readLightCullingStats();
+    void requestLightCullingStats();
+    void fitLightIndexList();
+    void growLightIndexList();
+    void resizeLightIndexList(const uint64_t capacity);
+    void gatherLights(FramePacket& packet, const float alpha);
+    void gatherLightRows();
+    void copyLightDataToGPU(const FramePacket& packet);
     void drawTextureToScreen(const GLuint texture);
     void generateRenderingQuad();
-    void tiledForwardPass();
+    void tiledForwardPass(const std::vector<DrawItem>& drawList);
     
 
     void debugPass();
     void generateSphereVAO();
 
-    Camera      _camera;
-    Transform   _cameraTransform;
+    void updateCameraBuffer(const CameraData& camera);
+
+    // Uniform block binding shared by all the shaders
+    const GLuint CAMERA_BLOCK_BINDING = 0;
+    CameraData  _cameraData {};
+    GLuint      _cameraBuffer;
+
+    // Window size and frame time target on the simulation thread, no target without dynamic resolution
+    uint32_t    _outputWidth        = 1280;
+    uint32_t    _outputHeight       = 720;
+    float       _targetFrameTime    = 0.0f;
+
+    // Window size of the drawn frame and internal resolution of the tiled pipeline
+    uint32_t    _frameWidth         = 1280;
+    uint32_t    _frameHeight        = 720;
+    uint32_t    _renderWidth        = 1280;
+    uint32_t    _renderHeight       = 720;
+    float       _renderScale        = 1.0f;
+    bool        _renderTargetsDirty = true;
+
+    // Dynamic resolution state of the drawn frames
+    float       _drawnTargetFrameTime       = 0.0f;
+    float       _smoothedFrameTime          = 0.0f;
+    uint32_t    _framesSinceScaleChange     = 0;
+
+    // Projection the tile frustums were computed with
+    glm::mat4   _frustumProjection  = glm::mat4(0.0f);
+    bool        _frustumsDirty      = true;
 
     World _world {};
 
@@ -73,6 +143,7 @@ class Renderer
 
     Shader _computeFrustumShader    {"./shaders/computeFrustum.comp"};
     Shader _tiledForwardShader      {"./shaders/tiledLightCulling.comp"};
+    Shader _prefixSumShader         {"./shaders/prefixSum.comp"};
 
     GLuint _defaultAlbedoTexture;
     GLuint _defaultMetallicRoughnessTexture;
@@ -89,10 +160,45 @@ class Renderer
     GLuint _gMetallicRoughness;
     unsigned int rboDepth;
 
+    GLuint _colorBuffer;
+    GLuint _gColor;
+    GLuint _colorDepthBuffer;
+
     GLuint _frustumBuffer;
     GLuint _lightsBuffer;
     GLuint _lightIndexCounterBuffer;
     GLuint _lightIndexListBuffer;
+    GLuint _tileLightOffsetsBuffer;
+    GLuint _lightCullingStatsBuffer;
+    GLuint _lightCullingStatsReadbackBuffer;
+    GLsync _lightCullingStatsFence = nullptr;
+
+    uint64_t            _lightIndexListCapacity = 0;
+    LightListLayout     _lightListLayout = LightListLayout::PerTileCap;
+    bool                _depthMaskCulling = true;
+    LightCullingStats   _lightCullingStats {};
+
+    uint64_t                _maxLights = 32768;
+
+    // Incremental light uploads, the simulation thread keeps the sent lights
+    const uint32_t          LIGHT_UPLOAD_GAP = 64;      // Clean lights merged between dirty ones
+    std::vector<PointLight> _lights;
+    std::vector<uint8_t>    _movingLights;              // Between two different transforms when sent
+    std::array<uint64_t, 3> _lightStructureVersions {}; // Of the light storages when sent
+    std::vector<glm::uvec3> _lightRows;                 // Dense indices of the sent lights, see gatherLightRows
+    uint64_t                _lightsUploadTick = 0;
+    uint32_t                _uploadedLightCount = 0;
+
+    // Lights of the drawn frame, the culling structures are built from them
+    std::vector<PointLight> _drawnLights;
+    uint32_t                _lightCount = 0;
+    bool                    _lightCullingDirty = true;
+
+    LightGrid               _lightGrid;
+    LightBVH                _lightBVH;
+    LightCulling            _lightCulling = LightCulling::Grid;
+
+    GpuTimer                _gpuTimer;
 
     GLuint _debugTexture;
     GLuint _gLightGrid;
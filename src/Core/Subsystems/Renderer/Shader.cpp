@@ -1,10 +1,13 @@
 #include "Shader.h"
+#include "../Memory/MemoryTracker.h"
 
 #include <sstream>
 #include <fstream>
 
 Shader::Shader(const std::string& vertexFilePath, const std::string& fragmentFilePath)
 {
+    MemoryScope scope(MemoryTag::Shader);
+
     std::string vertexCode;
     std::string fragmentCode;
     std::ifstream vShaderFile;
@@ -66,6 +69,8 @@ Shader::Shader(const std::string& vertexFilePath, const std::string& fragmentFil
 
 Shader::Shader(const std::string& computeFilePath)
 {
+    MemoryScope scope(MemoryTag::Shader);
+
     std::string computeCode;
     std::ifstream cShaderFile;
 
@@ -103,24 +108,29 @@ Shader::Shader(const std::string& computeFilePath)
     OK("Compute Shader \"" << computeFilePath << "\"");
 }
 
-void Shader::setMat4f(const std::string& name, const glm::mat4& mat) const
+void Shader::setMat4f(const char* name, const glm::mat4& mat) const
+{
+    glUniformMatrix4fv(glGetUniformLocation(_id, name), 1, GL_FALSE, glm::value_ptr(mat));
+}
+
+void Shader::set3f(const char* name, const glm::vec3& v) const
 {
-    glUniformMatrix4fv(glGetUniformLocation(_id, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+    glUniform3fv(glGetUniformLocation(_id, name), 1, glm::value_ptr(v));
 }
 
-void Shader::set3f(const std::string& name, const glm::vec3& v) const
+void Shader::set3i(const char* name, const glm::ivec3& v) const
 {
-    glUniform3fv(glGetUniformLocation(_id, name.c_str()), 1, glm::value_ptr(v));
+    glUniform3iv(glGetUniformLocation(_id, name), 1, glm::value_ptr(v));
 }
 
-void Shader::set1f(const std::string& name, const float f) const
+void Shader::set1f(const char* name, const float f) const
 {
-    glUniform1f(glGetUniformLocation(_id, name.c_str()), f);
+    glUniform1f(glGetUniformLocation(_id, name), f);
 }
 
-void Shader::set1i(const std::string& name, const int i) const
+void Shader::set1i(const char* name, const int i) const
 {
-    glUniform1i(glGetUniformLocation(_id, name.c_str()), i);
+    glUniform1i(glGetUniformLocation(_id, name), i);
 }
 
 void Shader::use() const
@@ -19,10 +19,11 @@ class Shader
  public:
     Shader(const std::string& vertexFilePath, const std::string& fragmentFilePath);
     Shader(const std::string& computeFilePath);
-    void setMat4f(const std::string& name, const glm::mat4& mat) const;
-    void set3f(const std::string& name, const glm::vec3& v) const;
-    void set1f(const std::string& name, const float f) const;
-    void set1i(const std::string& name, const int i) const;
+    void setMat4f(const char* name, const glm::mat4& mat) const;
+    void set3f(const char* name, const glm::vec3& v) const;
+    void set3i(const char* name, const glm::ivec3& v) const;
+    void set1f(const char* name, const float f) const;
+    void set1i(const char* name, const int i) const;
     void use() const;
 
  private:
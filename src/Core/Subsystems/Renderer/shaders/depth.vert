@@ -5,8 +5,15 @@ layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+layout (std140, binding = 0) uniform CameraBlock
+{
+    mat4 view;
+    mat4 projection;
+    mat4 invProjection;
+    mat4 invView;
+    vec4 viewPos;
+};
 
 void main()
 {
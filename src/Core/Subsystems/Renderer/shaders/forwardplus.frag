@@ -7,7 +7,6 @@ struct PointLight
     vec3    color;
     float   range;
     vec4    position;
-    vec4    positionVS;
 };
 
 in  vec2 texCoords;
@@ -32,7 +31,14 @@ uniform sampler2D       emissiveMap;
 uniform sampler2D       normalMap;
 uniform sampler2D       occlusionMap;
 
-uniform vec3            viewPos;
+layout (std140, binding = 0) uniform CameraBlock
+{
+    mat4 view;
+    mat4 projection;
+    mat4 invProjection;
+    mat4 invView;
+    vec4 viewPos;
+};
 
 vec3 fresnelSchlick(float cosTheta, vec3 F0)
 {
@@ -90,7 +96,7 @@ void main()
 
     
     vec3 N = normalize(TBN * (texture(normalMap, texCoords).rgb * 2.0 - 1.0));
-    vec3 V = normalize(viewPos - fragPos);
+    vec3 V = normalize(viewPos.xyz - fragPos);
 
     vec3 Lo = vec3(0.0);
     
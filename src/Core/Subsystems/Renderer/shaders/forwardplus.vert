@@ -10,8 +10,15 @@ out vec3 fragPos;
 out mat3 TBN;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+layout (std140, binding = 0) uniform CameraBlock
+{
+    mat4 view;
+    mat4 projection;
+    mat4 invProjection;
+    mat4 invView;
+    vec4 viewPos;
+};
 
 void main()
 {
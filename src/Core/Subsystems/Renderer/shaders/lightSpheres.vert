@@ -3,8 +3,15 @@
 layout (location = 0) in vec3 aPos;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+layout (std140, binding = 0) uniform CameraBlock
+{
+    mat4 view;
+    mat4 projection;
+    mat4 invProjection;
+    mat4 invView;
+    vec4 viewPos;
+};
 
 void main()
 {
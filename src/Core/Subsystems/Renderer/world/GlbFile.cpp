@@ -0,0 +1,132 @@
+#include "GlbFile.h"
+
+#include "./../../../utils.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Little endian fields of the header and of the chunk headers
+static const uint32_t GLB_MAGIC         = 0x46546C67;   // "glTF"
+static const uint32_t GLB_VERSION       = 2;
+static const uint32_t GLB_HEADER_SIZE   = 12;
+static const uint32_t CHUNK_HEADER_SIZE = 8;
+static const uint32_t CHUNK_JSON        = 0x4E4F534A;   // "JSON"
+static const uint32_t CHUNK_BIN         = 0x004E4942;   // "BIN\0"
+
+static uint32_t readUInt32(const unsigned char* data)
+{
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+GlbFile::~GlbFile()
+{
+    unmap();
+}
+
+bool GlbFile::map(const std::string& path)
+{
+    unmap();
+
+    const int file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        ERROR("Unable to open " << path);
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(file, &status) != 0 || status.st_size < static_cast<off_t>(GLB_HEADER_SIZE))
+    {
+        ERROR("Invalid .glb file " << path);
+        close(file);
+        return false;
+    }
+
+    // The mapping outlives the descriptor
+    void* data = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED)
+    {
+        ERROR("Unable to map " << path);
+        return false;
+    }
+    _data = static_cast<const unsigned char*>(data);
+    _size = status.st_size;
+
+    // Read ahead, the whole file is about to be parsed and uploaded
+    madvise(data, _size, MADV_WILLNEED);
+
+    const uint64_t length = readUInt32(_data + 8);
+    if (readUInt32(_data) != GLB_MAGIC || readUInt32(_data + 4) != GLB_VERSION || length > _size)
+    {
+        ERROR("Invalid .glb header in " << path);
+        unmap();
+        return false;
+    }
+
+    // A JSON chunk then an optional BIN chunk, other chunks are skipped
+    uint64_t offset = GLB_HEADER_SIZE;
+    while (offset + CHUNK_HEADER_SIZE <= length)
+    {
+        const uint64_t chunkLength = readUInt32(_data + offset);
+        const uint32_t chunkType = readUInt32(_data + offset + 4);
+        const uint64_t chunkStart = offset + CHUNK_HEADER_SIZE;
+        if (chunkStart + chunkLength > length)
+        {
+            ERROR("Truncated .glb chunk in " << path);
+            unmap();
+            return false;
+        }
+
+        if (offset == GLB_HEADER_SIZE && chunkType != CHUNK_JSON)
+        {
+            break;
+        }
+        if (chunkType == CHUNK_JSON && _json.empty())
+        {
+            _json = std::string_view(reinterpret_cast<const char*>(_data + chunkStart), chunkLength);
+        }
+        else if (chunkType == CHUNK_BIN && _bin.empty())
+        {
+            _bin = std::span<const unsigned char>(_data + chunkStart, chunkLength);
+        }
+
+        // Chunks are 4 bytes aligned
+        offset = chunkStart + (chunkLength + 3) / 4 * 4;
+    }
+
+    if (_json.empty())
+    {
+        ERROR("Missing JSON chunk in " << path);
+        unmap();
+        return false;
+    }
+    return true;
+}
+
+std::string_view GlbFile::json() const
+{
+    return _json;
+}
+
+std::span<const unsigned char> GlbFile::bin() const
+{
+    return _bin;
+}
+
+void GlbFile::unmap()
+{
+    if (_data != nullptr)
+    {
+        munmap(const_cast<unsigned char*>(_data), _size);
+    }
+    _data = nullptr;
+    _size = 0;
+    _json = {};
+    _bin = {};
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+// Binary glTF mapped in memory, its chunks are read in place
+class GlbFile
+{
+ public:
+    GlbFile() = default;
+    ~GlbFile();
+
+    GlbFile(const GlbFile&) = delete;
+    GlbFile& operator=(const GlbFile&) = delete;
+
+    // False when the file can not be mapped or is not a valid .glb
+    bool map(const std::string& path);
+
+    std::string_view json() const;
+    std::span<const unsigned char> bin() const;     // Empty without BIN chunk
+
+ private:
+    void unmap();
+
+    const unsigned char*            _data = nullptr;
+    uint64_t                        _size = 0;
+    std::string_view                _json;
+    std::span<const unsigned char>  _bin;
+};
@@ -1,53 +1,64 @@
 #include "./Mesh.h"
 
-#include <sstream>
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <utility>
 
 #include "../Renderer.h"
+#include "../GpuMemory.h"
 
-Mesh::Mesh(const int idx, const tinygltf::Model& model, std::vector<uint16_t>& indicesBuffer, std::vector<float>& vertexBuffer, std::vector<Primitive>& primitives)
+// Inputs of the tangent generation read in place, the tangents go to the vertices
+struct TangentSpace
 {
+    const Buffer<GLfloat>&  positions;
+    const Buffer<GLfloat>&  normals;
+    const Buffer<GLfloat>&  texCoords;
+    const IndexBuffer&      indices;
+    Vertex*                 vertices;
+};
+
+// Texture coordinates of the primitives without any, every vertex reads the same pair
+static const GLfloat ZERO_TEXCOORDS[2] = { 0.0f, 0.0f };
+
+// The accessors are read in place, the indices are uploaded straight from them and the
+// vertices are interleaved straight into the mapped GL buffer unless kept on the CPU
+Mesh::Mesh(const int idx, const tinygltf::Model& model, const SourceBuffers& buffers, const bool keepGeometry)
+{
+    _primitives.reserve(model.meshes[idx].primitives.size());
     for (const auto& pData : model.meshes[idx].primitives)
     {
         Primitive p;
 
-        const auto& pIndicesBuffer   = getBuffer<uint16_t>(pData.indices, model);
-        const auto& pVertexBuffer    = getBuffer<GLfloat>(pData.attributes.at("POSITION"), model);
-        const auto& pNormalBuffer    = getBuffer<GLfloat>(pData.attributes.at("NORMAL"), model);
-        const auto& pTexCoordBuffer  = [&]()
+        const IndexBuffer pIndicesBuffer        = getIndices(pData.indices, model, buffers);
+        const Buffer<GLfloat> pVertexBuffer     = getBuffer<GLfloat>(pData.attributes.at("POSITION"), model, buffers);
+        const Buffer<GLfloat> pNormalBuffer     = getBuffer<GLfloat>(pData.attributes.at("NORMAL"), model, buffers);
+        const Buffer<GLfloat> pTexCoordBuffer   = [&]()
         {
             // If has material
             if (pData.material >= 0)
             {
-                const auto material = model.materials[pData.material];
-                std::stringstream s;
-                s << "TEXCOORD_" << material.pbrMetallicRoughness.baseColorTexture.texCoord;
+                const auto& material = model.materials[pData.material];
+                const std::string name = "TEXCOORD_" + std::to_string(material.pbrMetallicRoughness.baseColorTexture.texCoord);
                 // If has texture
-                if (pData.attributes.find(s.str()) != pData.attributes.end())
+                const auto attribute = pData.attributes.find(name);
+                if (attribute != pData.attributes.end())
                 {
-                    return getBuffer<GLfloat>(pData.attributes.at(s.str()), model);
-                }         
+                    return getBuffer<GLfloat>(attribute->second, model, buffers);
+                }
             }
             // If no texture, zeros for all texcoord
-            std::vector<GLfloat> buffer((pVertexBuffer.size / 3) * 2, 0);
             return Buffer<GLfloat>
             {
-                .buffer = reinterpret_cast<const GLfloat*>(buffer.data()),
-                .size = (pVertexBuffer.size / 3) * 2,
+                .data = reinterpret_cast<const unsigned char*>(ZERO_TEXCOORDS),
+                .count = pVertexBuffer.count,
+                .stride = 0,
             };
         }();
 
-        size_t t = 0;
-        for (size_t i = 0; i < pVertexBuffer.size; i += 3)
+        if (pNormalBuffer.count != pVertexBuffer.count || pTexCoordBuffer.count != pVertexBuffer.count)
         {
-            const Vertex v =
-            {
-                .position = {pVertexBuffer.buffer[i], pVertexBuffer.buffer[i+1], pVertexBuffer.buffer[i+2]},
-                .normal = {pNormalBuffer.buffer[i],pNormalBuffer.buffer[i+1],pNormalBuffer.buffer[i+2]},
-                .texCoords = {pTexCoordBuffer.buffer[t],pTexCoordBuffer.buffer[t+1]},
-                .tangent = {0,0,0,0}
-            };
-            p.vertices.emplace_back(v);
-            t += 2;
+            ERROR_EXIT("Vertex attributes count mismatch in mesh " << idx);
         }
 
         // If has material
@@ -89,9 +100,70 @@ Mesh::Mesh(const int idx, const tinygltf::Model& model, std::vector<uint16_t>& i
             p.material.occlusionTextureStrength = material.occlusionTexture.strength;
         }
 
-        p.indices = std::vector<GLuint>(pIndicesBuffer.buffer, pIndicesBuffer.buffer+pIndicesBuffer.size);
+        p.vertexCount = static_cast<uint32_t>(pVertexBuffer.count);
+        p.indexCount = static_cast<uint32_t>(pIndicesBuffer.count);
+        p.indexType = pIndicesBuffer.type;
+
+        glGenVertexArrays(1, &p.VAO);
+        glGenBuffers(1, &p.VBO);
+        glGenBuffers(1, &p.EBO);
+
+        glBindVertexArray(p.VAO);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, p.EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, pIndicesBuffer.bytes(), pIndicesBuffer.data, GL_STATIC_DRAW);
+        trackBuffer(MemoryTag::World, p.EBO, pIndicesBuffer.bytes());
+
+        const uint64_t verticesSize = p.vertexCount * sizeof(Vertex);
+        glBindBuffer(GL_ARRAY_BUFFER, p.VBO);
+        glBufferData(GL_ARRAY_BUFFER, verticesSize, nullptr, GL_STATIC_DRAW);
+        trackBuffer(MemoryTag::World, p.VBO, verticesSize);
+
+        // Write only when mapped, nothing is read back from the vertices
+        Vertex* vertices = nullptr;
+        if (keepGeometry)
+        {
+            p.vertices.resize(p.vertexCount);
+            vertices = p.vertices.data();
+        }
+        else if (p.vertexCount > 0)
+        {
+            vertices = static_cast<Vertex*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, verticesSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+            if (vertices == nullptr)
+            {
+                ERROR_EXIT("Unable to map the vertex buffer of mesh " << idx);
+            }
+        }
+
+        p.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+        p.boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+        for (size_t i = 0; i < pVertexBuffer.count; ++i)
+        {
+            const GLfloat* position = pVertexBuffer[i];
+            const GLfloat* normal = pNormalBuffer[i];
+            const GLfloat* texCoords = pTexCoordBuffer[i];
+            const glm::vec3 v = {position[0], position[1], position[2]};
+            vertices[i] =
+            {
+                .position = v,
+                .normal = {normal[0], normal[1], normal[2]},
+                .texCoords = {texCoords[0], texCoords[1]},
+                .tangent = {0,0,0,0}
+            };
+            p.boundsMin = glm::min(p.boundsMin, v);
+            p.boundsMax = glm::max(p.boundsMax, v);
+        }
 
         // Primitive Tangent calculation
+        TangentSpace tangentSpace
+        {
+            .positions = pVertexBuffer,
+            .normals = pNormalBuffer,
+            .texCoords = pTexCoordBuffer,
+            .indices = pIndicesBuffer,
+            .vertices = vertices
+        };
+
         SMikkTSpaceInterface interface =
         {
             .m_getNumFaces = getNumFaces,
@@ -106,22 +178,24 @@ Mesh::Mesh(const int idx, const tinygltf::Model& model, std::vector<uint16_t>& i
         SMikkTSpaceContext context =
         {
             .m_pInterface = &interface,
-            .m_pUserData = &p
+            .m_pUserData = &tangentSpace
         };
 
         genTangSpaceDefault(&context);
 
-        glGenVertexArrays(1, &p.VAO);
-        glGenBuffers(1, &p.VBO);
-        glGenBuffers(1, &p.EBO);
-
-        glBindVertexArray(p.VAO);
-
-        glBindBuffer(GL_ARRAY_BUFFER, p.VBO);
-        glBufferData(GL_ARRAY_BUFFER, p.vertices.size() * sizeof(Vertex), p.vertices.data(), GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, p.EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, p.indices.size() * sizeof(GLuint), p.indices.data(), GL_STATIC_DRAW);
+        if (keepGeometry)
+        {
+            glBufferSubData(GL_ARRAY_BUFFER, 0, verticesSize, p.vertices.data());
+            p.indices.resize(p.indexCount);
+            for (size_t i = 0; i < pIndicesBuffer.count; ++i)
+            {
+                p.indices[i] = pIndicesBuffer[i];
+            }
+        }
+        else if (vertices != nullptr && glUnmapBuffer(GL_ARRAY_BUFFER) == GL_FALSE)
+        {
+            ERROR("Vertex buffer of mesh " << idx << " corrupted while mapped");
+        }
 
         // Vertex positions
         glEnableVertexAttribArray(0);	
@@ -138,7 +212,20 @@ Mesh::Mesh(const int idx, const tinygltf::Model& model, std::vector<uint16_t>& i
 
         glBindVertexArray(0);
 
-        _primitives.emplace_back(p);
+        _primitives.push_back(std::move(p));
+    }
+}
+
+// Shared by the nodes instancing the mesh, released with the last one
+Mesh::~Mesh()
+{
+    for (const auto& p : _primitives)
+    {
+        MemoryTracker::untrackGpu(GpuResource::Buffer, p.VBO);
+        MemoryTracker::untrackGpu(GpuResource::Buffer, p.EBO);
+        glDeleteBuffers(1, &p.VBO);
+        glDeleteBuffers(1, &p.EBO);
+        glDeleteVertexArrays(1, &p.VAO);
     }
 }
 
@@ -147,17 +234,68 @@ const std::vector<Primitive>& Mesh::getPrimitives() const
     return _primitives;
 }
 
+const unsigned char* Mesh::accessorData(const int from, const tinygltf::Model& model, const SourceBuffers& buffers, const size_t elementSize, size_t& stride) const
+{
+    const auto& accessor = model.accessors[from];
+    if (accessor.bufferView < 0)
+    {
+        ERROR_EXIT("Accessor " << from << " without buffer view");
+    }
+    const auto& bufferView = model.bufferViews[accessor.bufferView];
+    const int byteStride = accessor.ByteStride(bufferView);
+    if (byteStride <= 0 || bufferView.buffer < 0 || static_cast<size_t>(bufferView.buffer) >= buffers.size())
+    {
+        ERROR_EXIT("Accessor " << from << " with an invalid buffer view");
+    }
+    stride = static_cast<size_t>(byteStride);
+
+    const auto& buffer = buffers[bufferView.buffer];
+    const size_t offset = bufferView.byteOffset + accessor.byteOffset;
+    const size_t size = accessor.count == 0 ? 0 : (accessor.count - 1) * stride + elementSize;
+    if (offset + size > buffer.size())
+    {
+        ERROR_EXIT("Accessor " << from << " out of its buffer");
+    }
+    return buffer.data() + offset;
+}
+
+IndexBuffer Mesh::getIndices(const int from, const tinygltf::Model& model, const SourceBuffers& buffers) const
+{
+    const auto& accessor = model.accessors[from];
+    IndexBuffer indices;
+    indices.type = static_cast<GLenum>(accessor.componentType);
+    indices.count = accessor.count;
+
+    // Index views are tightly packed
+    size_t stride;
+    indices.data = accessorData(from, model, buffers, indices.bytes() / std::max<size_t>(indices.count, 1), stride);
+    return indices;
+}
+
+MeshCache::MeshCache(const tinygltf::Model& model, SourceBuffers buffers, const bool keepGeometry) : _model(model), _buffers(std::move(buffers)), _keepGeometry(keepGeometry), _meshes(model.meshes.size())
+{
+}
+
+std::shared_ptr<Mesh> MeshCache::get(const int idx)
+{
+    if (!_meshes[idx])
+    {
+        _meshes[idx] = std::make_shared<Mesh>(idx, _model, _buffers, _keepGeometry);
+    }
+    return _meshes[idx];
+}
+
 int getVertexIndex(const SMikkTSpaceContext* context, int iFace, int iVert)
 {
-    const Primitive* prim = static_cast<const Primitive*>(context->m_pUserData);
+    const TangentSpace* tangentSpace = static_cast<const TangentSpace*>(context->m_pUserData);
     const int64_t faceSize = getNumVerticesOfFace(context, iFace);
-    return prim->indices[(iFace * faceSize) + iVert];
+    return tangentSpace->indices[(iFace * faceSize) + iVert];
 }
 
 int getNumFaces(const SMikkTSpaceContext* context)
 {
-    const Primitive* prim = static_cast<const Primitive*>(context->m_pUserData);
-    return static_cast<int>(prim->indices.size() / 3);
+    const TangentSpace* tangentSpace = static_cast<const TangentSpace*>(context->m_pUserData);
+    return static_cast<int>(tangentSpace->indices.count / 3);
 }
 
 int getNumVerticesOfFace(const SMikkTSpaceContext* context, int iFace)
@@ -167,34 +305,34 @@ int getNumVerticesOfFace(const SMikkTSpaceContext* context, int iFace)
 
 void getNormal(const SMikkTSpaceContext* context, float outnormal[], int iFace, int iVert)
 {
-    const Primitive* prim = static_cast<const Primitive*>(context->m_pUserData);
-    const Vertex& vertex = prim->vertices[getVertexIndex(context, iFace, iVert)];
-    outnormal[0] = vertex.normal.x;
-    outnormal[1] = vertex.normal.y;
-    outnormal[2] = vertex.normal.z;
+    const TangentSpace* tangentSpace = static_cast<const TangentSpace*>(context->m_pUserData);
+    const GLfloat* normal = tangentSpace->normals[getVertexIndex(context, iFace, iVert)];
+    outnormal[0] = normal[0];
+    outnormal[1] = normal[1];
+    outnormal[2] = normal[2];
 }
 
 void getPosition(const SMikkTSpaceContext* context, float outpos[], int iFace, int iVert)
 {
-    const Primitive* prim = static_cast<const Primitive*>(context->m_pUserData);
-    const Vertex& vertex = prim->vertices[getVertexIndex(context, iFace, iVert)];
-    outpos[0] = vertex.position.x;
-    outpos[1] = vertex.position.y;
-    outpos[2] = vertex.position.z;
+    const TangentSpace* tangentSpace = static_cast<const TangentSpace*>(context->m_pUserData);
+    const GLfloat* position = tangentSpace->positions[getVertexIndex(context, iFace, iVert)];
+    outpos[0] = position[0];
+    outpos[1] = position[1];
+    outpos[2] = position[2];
 }
 
 void getTexCoords(const SMikkTSpaceContext* context, float outuv[], int iFace, int iVert)
 {
-    const Primitive* prim = static_cast<const Primitive*>(context->m_pUserData);
-    const Vertex& vertex = prim->vertices[getVertexIndex(context, iFace, iVert)];
-    outuv[0] = vertex.texCoords.x;
-    outuv[1] = vertex.texCoords.y;
+    const TangentSpace* tangentSpace = static_cast<const TangentSpace*>(context->m_pUserData);
+    const GLfloat* texCoords = tangentSpace->texCoords[getVertexIndex(context, iFace, iVert)];
+    outuv[0] = texCoords[0];
+    outuv[1] = texCoords[1];
 }
 
 void setTSpaceBasic(const SMikkTSpaceContext* context, const float tangentu[], float fSign, int iFace, int iVert)
 {
-    Primitive* prim = static_cast<Primitive*>(context->m_pUserData);
-    Vertex& vertex = prim->vertices[getVertexIndex(context, iFace, iVert)];
+    const TangentSpace* tangentSpace = static_cast<const TangentSpace*>(context->m_pUserData);
+    Vertex& vertex = tangentSpace->vertices[getVertexIndex(context, iFace, iVert)];
 
     vertex.tangent.x = tangentu[0];
     vertex.tangent.y = tangentu[1];
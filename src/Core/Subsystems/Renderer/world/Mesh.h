@@ -2,6 +2,8 @@
 
 #include <tiny_gltf.h>
 #include <cstdint>
+#include <memory>
+#include <span>
 #include <vector>
 #include <glm/glm.hpp>
 #include <glad/gl.h>
@@ -9,11 +11,47 @@
 #include "./../../../utils.h"
 #include "MikkTSpace/mikktspace.h"
 
+// Bytes of each buffer of a model, loaded by tinygltf or mapped from the file
+using SourceBuffers = std::vector<std::span<const unsigned char>>;
+
+// Elements of an accessor read in place, byteStride apart
 template<typename T>
 struct Buffer
 {
-    const T*        buffer = nullptr;
-    const size_t    size = 0;
+    const unsigned char*    data = nullptr;
+    size_t                  count = 0;
+    size_t                  stride = 0;
+
+    const T* operator[](const size_t i) const
+    {
+        return reinterpret_cast<const T*>(data + i * stride);
+    }
+};
+
+// Indices of a primitive read in place, in their glTF type which is also their GL one
+struct IndexBuffer
+{
+    const unsigned char*    data = nullptr;
+    size_t                  count = 0;
+    GLenum                  type = GL_UNSIGNED_INT;
+
+    GLuint operator[](const size_t i) const
+    {
+        switch (type)
+        {
+            case GL_UNSIGNED_BYTE:
+                return data[i];
+            case GL_UNSIGNED_SHORT:
+                return reinterpret_cast<const uint16_t*>(data)[i];
+            default:
+                return reinterpret_cast<const uint32_t*>(data)[i];
+        }
+    }
+
+    size_t bytes() const
+    {
+        return count * (type == GL_UNSIGNED_BYTE ? 1 : type == GL_UNSIGNED_SHORT ? 2 : 4);
+    }
 };
 
 struct Vertex
@@ -53,6 +91,12 @@ struct Primitive
     GLuint                  VAO;
     GLuint                  VBO;
     GLuint                  EBO;
+    uint32_t                vertexCount = 0;
+    uint32_t                indexCount = 0;
+    GLenum                  indexType = GL_UNSIGNED_INT;
+    glm::vec3               boundsMin;
+    glm::vec3               boundsMax;
+    // Copies of the uploaded geometry, empty unless kept when loading
     std::vector<Vertex>     vertices;
     std::vector<GLuint>     indices;
     Material                material;
@@ -61,44 +105,49 @@ struct Primitive
 class Mesh
 {
  public:
-    Mesh(const int idx, const tinygltf::Model& model, std::vector<uint16_t>& indicesBuffer, std::vector<float>& vertexBuffer, std::vector<Primitive>& primitives);
+    Mesh(const int idx, const tinygltf::Model& model, const SourceBuffers& buffers, const bool keepGeometry);
+    ~Mesh();
+
+    // Owns the GL objects of its primitives
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+
     const std::vector<Primitive>& getPrimitives() const;
 
  private:
+    // Bytes of an accessor, checked to lie within its buffer
+    const unsigned char* accessorData(const int from, const tinygltf::Model& model, const SourceBuffers& buffers, const size_t elementSize, size_t& stride) const;
+
     template<typename T>
-    const Buffer<T> getBuffer(const int from, const tinygltf::Model& model) const
+    Buffer<T> getBuffer(const int from, const tinygltf::Model& model, const SourceBuffers& buffers) const
     {
-        const auto&  accessor   = model.accessors[from];
-        const auto&  bufferView = model.bufferViews[accessor.bufferView];
-        const auto&  buffer     = model.buffers[bufferView.buffer];
-        const size_t typeSize   = [&accessor]()
-        {
-            switch(accessor.type)
-            {
-                case TINYGLTF_TYPE_SCALAR:
-                    return 1;
-                case TINYGLTF_TYPE_VEC2:
-                    return 2;
-                case TINYGLTF_TYPE_VEC3:
-                    return 3;
-                case TINYGLTF_TYPE_VEC4:
-                    return 4;
-                default:
-                    ERROR_EXIT("Accessor data type unknown yet");
-            }
-        }();
-        const size_t bufferSize = accessor.count * typeSize;
-
-        return
-        {
-            .buffer = reinterpret_cast<const T*>(&buffer.data[bufferView.byteOffset + accessor.byteOffset]),
-            .size = bufferSize,
-        };
+        const auto& accessor = model.accessors[from];
+        const size_t elementSize = tinygltf::GetNumComponentsInType(accessor.type) * sizeof(T);
+        Buffer<T> buffer;
+        buffer.data = accessorData(from, model, buffers, elementSize, buffer.stride);
+        buffer.count = accessor.count;
+        return buffer;
     }
 
+    IndexBuffer getIndices(const int from, const tinygltf::Model& model, const SourceBuffers& buffers) const;
+
     std::vector<Primitive> _primitives;
 };
 
+// Meshes of a model, created on first use and shared by the nodes instancing them
+class MeshCache
+{
+ public:
+    MeshCache(const tinygltf::Model& model, SourceBuffers buffers, const bool keepGeometry);
+    std::shared_ptr<Mesh> get(const int idx);
+
+ private:
+    const tinygltf::Model&              _model;
+    const SourceBuffers                 _buffers;
+    const bool                          _keepGeometry;
+    std::vector<std::shared_ptr<Mesh>>  _meshes;
+};
+
 static int  getVertexIndex(const SMikkTSpaceContext* context, int iFace, int iVert);
 static int  getNumFaces(const SMikkTSpaceContext* context);
 static int  getNumVerticesOfFace(const SMikkTSpaceContext* context, int iFace);
@@ -8,7 +8,7 @@
 #include <glm/gtx/quaternion.hpp>
 #include <memory>
 
-Node::Node(const int idx, const tinygltf::Model& model, std::vector<uint16_t>& indicesBuffer, std::vector<float>& vertexBuffer, std::vector<Primitive>& primitives, std::vector<Node>& nodes, const glm::mat4& parentTransform)
+Node::Node(const int idx, const tinygltf::Model& model, MeshCache& meshes, std::vector<Node>& nodes, const glm::mat4& parentTransform)
 {
     const auto& node = model.nodes[idx];
     INFO("Loading node \"" << node.name << "\""); 
@@ -55,13 +55,13 @@ Node::Node(const int idx, const tinygltf::Model& model, std::vector<uint16_t>& i
 
     for (const auto childrenIdx : node.children)
     {
-        const Node node {childrenIdx, model, indicesBuffer, vertexBuffer, primitives, nodes, _transform};
-        nodes.emplace_back(node);
+        Node node {childrenIdx, model, meshes, nodes, _transform};
+        nodes.push_back(std::move(node));
     }
 
     if (node.mesh >= 0)
     {
-        _mesh = std::make_shared<Mesh>(node.mesh, model, indicesBuffer, vertexBuffer, primitives);
+        _mesh = meshes.get(node.mesh);
     }
 }
 
@@ -5,15 +5,9 @@
 class Scene
 {
  public:
-    Scene(const std::vector<int>& nodesIdx, const tinygltf::Model& model);
-    const std::vector<uint16_t>& getIndicesBuffer() const;
-    const std::vector<float>& getPositionBuffer() const;
-    const std::vector<Primitive>& getPrimitives() const;
+    Scene(const std::vector<int>& nodesIdx, const tinygltf::Model& model, MeshCache& meshes);
     const std::vector<Node>& getNodes() const;
 
  private:
     std::vector<Node>           _nodes;
-    std::vector<uint16_t>       _indicesBuffer;
-    std::vector<float>          _vertexBuffer;
-    std::vector<Primitive>      _primitives;
 };
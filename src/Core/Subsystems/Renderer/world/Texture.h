@@ -2,8 +2,10 @@
 
 #include "./../../../utils.h"
 #include "Mesh.h"
+#include "../GpuMemory.h"
 
 #include <memory>
+#include <utility>
 
 struct Texture
 {
@@ -50,8 +52,38 @@ struct Texture
         }
         glTexImage2D(GL_TEXTURE_2D, 0, GL_COMPRESSED_RGB, img.width, img.height, 0, format, type, img.image.data());
         glGenerateMipmap(GL_TEXTURE_2D);
+
+        // The driver picks the compressed format, its size is only known once uploaded
+        GLint compressed = GL_FALSE;
+        GLint size = static_cast<GLint>(img.width * img.height * texelSize(GL_RGB));
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &compressed);
+        if (compressed == GL_TRUE)
+        {
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+        }
+        // The mip chain adds a third
+        MemoryTracker::trackGpu(MemoryTag::World, GpuResource::Texture, id, static_cast<uint64_t>(size) * 4 / 3);
         OK("Texture " << gltfTexture.source);
     }
 
-    GLuint id;
+    ~Texture()
+    {
+        if (id != 0)
+        {
+            MemoryTracker::untrackGpu(GpuResource::Texture, id);
+            glDeleteTextures(1, &id);
+        }
+    }
+
+    // Owns its GL texture
+    Texture(const Texture&) = delete;
+    Texture& operator=(const Texture&) = delete;
+    Texture(Texture&& other) noexcept : id(std::exchange(other.id, 0)) {}
+    Texture& operator=(Texture&& other) noexcept
+    {
+        std::swap(id, other.id);
+        return *this;
+    }
+
+    GLuint id = 0;
 };
@@ -1,23 +1,118 @@
 #include "World.h"
+#include "GlbFile.h"
 
 #define TINYGLTF_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #define TINYGLTF_NOEXCEPTION
 #include <tiny_gltf.h>
+#include <json.hpp>     // Bundled with tinygltf
 
-World::World()
+#include <algorithm>
+#include <filesystem>
+#include <span>
+
+// One byte buffer standing for the BIN chunk of a .glb, which tinygltf would copy
+static const char* BIN_PLACEHOLDER_URI = "data:application/octet-stream;base64,AA==";
+
+// Unsigned field of a JSON object, the fallback when missing or mistyped
+static uint64_t jsonUInt(const nlohmann::json& object, const char* key, const uint64_t fallback)
+{
+    const auto field = object.find(key);
+    return field != object.end() && field->is_number_unsigned() ? field->get<uint64_t>() : fallback;
+}
+
+// The images stored in the BIN chunk are decoded from the mapping
+static bool loadGlbImage(tinygltf::Image* image, const int imageIdx, std::string* err, std::string* warn, int reqWidth, int reqHeight, const unsigned char* bytes, int size, void* userData)
+{
+    const auto& images = *static_cast<const std::vector<std::span<const unsigned char>>*>(userData);
+    if (static_cast<size_t>(imageIdx) < images.size() && !images[imageIdx].empty())
+    {
+        bytes = images[imageIdx].data();
+        size = static_cast<int>(images[imageIdx].size());
+    }
+    return tinygltf::LoadImageData(image, imageIdx, err, warn, reqWidth, reqHeight, bytes, size, nullptr);
+}
+
+// tinygltf is only handed the JSON chunk, the BIN chunk buffer replaced by a one byte
+// placeholder so nothing is copied, the meshes then read the chunk in the mapping
+// The images of the chunk point to a one byte view instead and are decoded in place
+static bool loadGlb(const GlbFile& glb, const std::string& baseDir, tinygltf::TinyGLTF& loader, tinygltf::Model& model, std::string& err, std::string& warn, bool& binBuffer)
+{
+    nlohmann::json json = nlohmann::json::parse(glb.json().begin(), glb.json().end(), nullptr, false);
+    if (json.is_discarded() || !json.is_object())
+    {
+        err = "Invalid JSON chunk";
+        return false;
+    }
+
+    // Only the first buffer may be the BIN chunk, it is the one without uri
+    const auto buffers = json.find("buffers");
+    binBuffer = buffers != json.end() && buffers->is_array() && !buffers->empty() && (*buffers)[0].is_object() && !(*buffers)[0].contains("uri");
+
+    std::vector<std::span<const unsigned char>> images;
+    if (binBuffer)
+    {
+        if (jsonUInt((*buffers)[0], "byteLength", 0) > glb.bin().size())
+        {
+            err = "BIN chunk smaller than its buffer";
+            return false;
+        }
+        (*buffers)[0] = { {"byteLength", 1}, {"uri", BIN_PLACEHOLDER_URI} };
+
+        const auto bufferViews = json.find("bufferViews");
+        const auto jsonImages = json.find("images");
+        if (bufferViews != json.end() && bufferViews->is_array() && jsonImages != json.end() && jsonImages->is_array())
+        {
+            const uint64_t placeholderView = bufferViews->size();
+            images.resize(jsonImages->size());
+            for (size_t i = 0; i < jsonImages->size(); ++i)
+            {
+                auto& image = (*jsonImages)[i];
+                const uint64_t viewIdx = jsonUInt(image, "bufferView", placeholderView);
+                if (viewIdx >= placeholderView || jsonUInt((*bufferViews)[viewIdx], "buffer", 0) != 0)
+                {
+                    continue;
+                }
+
+                const auto& view = (*bufferViews)[viewIdx];
+                const uint64_t offset = jsonUInt(view, "byteOffset", 0);
+                const uint64_t length = jsonUInt(view, "byteLength", 0);
+                if (offset + length > glb.bin().size())
+                {
+                    err = "Image " + std::to_string(i) + " out of the BIN chunk";
+                    return false;
+                }
+                images[i] = glb.bin().subspan(offset, length);
+                image["bufferView"] = placeholderView;
+            }
+            bufferViews->push_back({ {"buffer", 0}, {"byteLength", 1} });
+        }
+    }
+
+    loader.SetImageLoader(loadGlbImage, &images);
+    const std::string text = json.dump();
+    return loader.LoadASCIIFromString(&model, &err, &warn, text.c_str(), static_cast<unsigned int>(text.size()), baseDir);
+}
+
+// Load a .gltf or .glb file, replacing the current world
+// A .glb is mapped and its BIN chunk read in place, with no copy before the upload
+// The geometry only lives on the GPU once uploaded unless kept
+void World::load(const std::string& path, const bool keepGeometry)
 {
     tinygltf::Model model;
     tinygltf::TinyGLTF loader;
     std::string err;
     std::string warn;
 
-    //bool ret = loader.LoadASCIIFromFile(&model, &err, &warn, "models/scene.gltf");
-    bool ret = loader.LoadASCIIFromFile(&model, &err, &warn, "models/Sponza.gltf");
-    //bool ret = loader.LoadBinaryFromFile(&model, &err, &warn, "models/MetalRoughSpheres.glb");
-    //bool ret = loader.LoadBinaryFromFile(&model, &err, &warn, "models/scene-light.glb");
- 
+    // Mapped until the meshes and textures are uploaded
+    GlbFile glb;
+    bool binBuffer = false;
+
+    const bool binary = path.size() >= 4 && path.compare(path.size() - 4, 4, ".glb") == 0;
+    bool ret = binary ? glb.map(path) && loadGlb(glb, std::filesystem::path(path).parent_path().string(), loader, model, err, warn, binBuffer)
+                      : loader.LoadASCIIFromFile(&model, &err, &warn, path);
+
     if (!warn.empty())
     {
         WARNING(warn.c_str());
@@ -30,21 +125,37 @@ World::World()
 
     if (!ret)
     {
-        ERROR_EXIT("Failed to load glTF file.");
+        ERROR_EXIT("Failed to load glTF file " << path << '.');
+    }
+
+    _scenes.clear();
+    _textures.clear();
+
+    SourceBuffers buffers;
+    buffers.reserve(model.buffers.size());
+    for (const auto& buffer : model.buffers)
+    {
+        buffers.emplace_back(buffer.data);
+    }
+    if (binBuffer)
+    {
+        buffers[0] = glb.bin();
     }
 
+    // Scenes and nodes instancing a mesh share it
+    MeshCache meshes {model, std::move(buffers), keepGeometry};
+    _scenes.reserve(model.scenes.size());
     for (const auto& gltfScene : model.scenes)
     {
-        const Scene scene {gltfScene.nodes, model};
-        _scenes.emplace_back(scene);
+        _scenes.emplace_back(gltfScene.nodes, model, meshes);
     }
 
-    _currentScene = model.defaultScene;
+    _currentScene = std::max(model.defaultScene, 0);
 
+    _textures.reserve(model.textures.size());
     for (const auto& gltfTexture : model.textures)
     {
-        const Texture texture {gltfTexture, model};
-        _textures.emplace_back(texture);
+        _textures.emplace_back(gltfTexture, model);
     }
 }
 
@@ -4,15 +4,17 @@
 #include "./Scene.h"
 #include "./Texture.h"
 
+#include <string>
+
 class World
 {
  public:
-    World();
+    void load(const std::string& path, const bool keepGeometry);
     const std::vector<Node>& getNodes() const;
     const std::vector<Texture>& getTextures() const;
 
  private:
     std::vector<Scene>          _scenes;
-    uint16_t                    _currentScene;
+    uint16_t                    _currentScene = 0;
     std::vector<Texture>        _textures;
 };
@@ -16,7 +16,7 @@ Window::Window()
     }
 
     glfwSetErrorCallback(&Window::glfwError);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -28,6 +28,7 @@ Window::Window()
 
     glfwSetKeyCallback(_glfwWindow.get(), g_InputManager.keyCallback);
     glfwSetCursorPosCallback(_glfwWindow.get(), g_InputManager.cursorPositionCallback);
+    glfwSetFramebufferSizeCallback(_glfwWindow.get(), &Window::framebufferSizeCallback);
     if (glfwRawMouseMotionSupported())
     {
         glfwSetInputMode(_glfwWindow.get(), GLFW_RAW_MOUSE_MOTION, GLFW_TRUE);
@@ -39,8 +40,6 @@ Window::Window()
         ERROR_EXIT("Failed to initialize OpenGL context");
     }
 
-    glViewport(0, 0, 1280, 720);
-
     OK("OpenGL");
 }
 
@@ -91,6 +90,40 @@ void Window::windowGetFramebufferSize(uint32_t& width, uint32_t& height)
     height = static_cast<uint32_t>(intHeight);
 }
 
+// A hidden window keeps the context, used as an offscreen one
+void Window::setVisible(const bool visible)
+{
+    if (visible)
+    {
+        glfwShowWindow(_glfwWindow.get());
+    }
+    else
+    {
+        glfwHideWindow(_glfwWindow.get());
+    }
+}
+
+void Window::setSize(const uint32_t width, const uint32_t height)
+{
+    glfwSetWindowSize(_glfwWindow.get(), static_cast<int>(width), static_cast<int>(height));
+}
+
+void Window::makeContextCurrent()
+{
+    glfwMakeContextCurrent(_glfwWindow.get());
+}
+
+void Window::releaseContext()
+{
+    glfwMakeContextCurrent(nullptr);
+}
+
+// The next frame packet carries the size, the renderer resizes its targets when drawing it
+void Window::framebufferSizeCallback(GLFWwindow* window, int width, int height)
+{
+    g_Renderer.setOutputResolution(static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+}
+
 void Window::keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
     if (key == GLFW_KEY_R && action == GLFW_PRESS)
@@ -19,11 +19,18 @@ class Window
     void pollEvents();
     void swapBuffers();
     void windowGetFramebufferSize(uint32_t& width, uint32_t& height);
+    void setVisible(const bool visible);
+    void setSize(const uint32_t width, const uint32_t height);
+
+    // Move the GL context between threads, it is current on one at a time
+    void makeContextCurrent();
+    void releaseContext();
 
  private:
     void windowInit();
     static void glfwError(int error, const char* description);
     static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+    static void framebufferSizeCallback(GLFWwindow* window, int width, int height);
 
     std::unique_ptr<GLFWwindow, glfwDeleter> _glfwWindow = nullptr;
 };
@@ -1,10 +1,29 @@
 #pragma once
 
 #include <bitset>
+#include <cstdint>
+#include <limits>
 
-// Entity alias and maximum
+// Entity handle: 32-bit slot index in the low bits and the generation of
+// the slot in the high bits, so a stale handle never aliases a new entity
 using Entity = uint64_t;
-const Entity MAX_ENTITIES = 65536+5000;
+using EntityIndex = uint32_t;
+const EntityIndex MAX_ENTITIES = std::numeric_limits<EntityIndex>::max();
+
+constexpr EntityIndex entityIndex(Entity entity)
+{
+    return static_cast<EntityIndex>(entity);
+}
+
+constexpr uint32_t entityGeneration(Entity entity)
+{
+    return static_cast<uint32_t>(entity >> 32);
+}
+
+constexpr Entity makeEntity(EntityIndex index, uint32_t generation)
+{
+    return (static_cast<Entity>(generation) << 32) | index;
+}
 
 // Components alias and maximum
 using ComponentType = uint8_t;
@@ -12,4 +31,3 @@ const ComponentType MAX_COMPONENTS = 16;
 
 // Signature alias
 using Signature = std::bitset<MAX_COMPONENTS>;
-
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Subsystems/Log/Logger.h"
+
 #include <iostream>
 
 #define CHECK(m,f) \
@@ -11,43 +13,31 @@
     OK(m);\
     }\
 
-#define INFO(m) \
+// Queued for the logger thread, never blocks the caller
+#define LOG(level, m) \
     {\
-    std::cerr << "   \033[44m\033[1m[INFO]\033[49m\033[0m "; \
-    std::cerr << m << '\n'; \
+    if constexpr (static_cast<int>(level) >= LOG_MIN_LEVEL) \
+    { \
+        LogRecord(level) << m; \
+    } \
     }
 
-#define OK(m) \
-    {\
-    std::cerr << "   \033[42m\033[1m[ OK ]\033[49m\033[0m "; \
-    std::cerr << m << '\n'; \
-    }
-
-#define WARNING(m) \
-    {\
-    std::cerr << "\033[43m\033[1m[WARNING]\033[49m\033[0m "; \
-    std::cerr << m << '\n'; \
-    }
+#define INFO(m)     LOG(LogLevel::Info, m)
+#define OK(m)       LOG(LogLevel::Ok, m)
+#define WARNING(m)  LOG(LogLevel::Warning, m)
+#define ERROR(m)    LOG(LogLevel::Error, m)
 
 #define WARNING_FILE(m) \
-    {\
-    std::cerr << '\n'; \
-    std::cerr << "\033[43m\033[1m[WARNING]\033[49m\033[0m " << '\n'; \
-    std::cerr << "\033[1mFILE\033[0m    : " << __FILE__ << '\n'; \
-    std::cerr << "\033[1mFUNCTION\033[0m: " << __func__ << '\n'; \
-    std::cerr << "\033[1mLINE\033[0m    : " << __LINE__ << '\n'; \
-    std::cerr << "\033[1mMESSAGE\033[0m : " << m << '\n'; \
-    std::cerr << '\n'; \
-    }
-
-#define ERROR(m) \
-    {\
-    std::cerr << "  \033[41m\033[1m[ERROR]\033[49m\033[0m "; \
-    std::cerr << m << '\n'; \
-    }
+    LOG(LogLevel::Warning, '\n' \
+        << "\033[1mFILE\033[0m    : " << __FILE__ << '\n' \
+        << "\033[1mFUNCTION\033[0m: " << __func__ << '\n' \
+        << "\033[1mLINE\033[0m    : " << __LINE__ << '\n' \
+        << "\033[1mMESSAGE\033[0m : " << m << '\n')
 
+// Fatal errors are written synchronously, after the queued records
 #define ERROR_EXIT(m) \
     {\
+    Logger::instance().flush(); \
     std::cerr << '\n'; \
     std::cerr << "\033[41m\033[1m[ERROR]\033[49m\033[0m " << '\n'; \
     std::cerr << "\033[1mFILE\033[0m    : " << __FILE__ << '\n'; \
@@ -62,6 +52,7 @@
 #define ASSERT(c, m) \
     {\
     if (!(c)) { \
+        Logger::instance().flush(); \
         std::cerr << '\n'; \
         std::cerr << "\033[41m\033[1m[ASSERT ERROR]\033[49m\033[0m " << '\n'; \
         std::cerr << "\033[1mFILE\033[0m    : " << __FILE__ << '\n'; \
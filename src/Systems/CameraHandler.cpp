@@ -4,9 +4,12 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/string_cast.hpp>
 
+#include <utility>
+
 #include "../Core/Subsystems/ECS/ECSManager.h"
 #include "../Core/Subsystems/Renderer/Renderer.h"
 #include "../Core/Subsystems/Input/InputManager.h"
+#include "../Components/MainCamera.h"
 
 extern ECSManager   g_ECSManager;
 extern Renderer     g_Renderer;
@@ -14,23 +17,42 @@ extern InputManager g_InputManager;
 
 void CameraHandler::Update(const float dt)
 {
-    // Only using the first camera
-    auto& transform = g_ECSManager.getComponent<Transform>(*_entities.begin());
-    auto& camera    = g_ECSManager.getComponent<Camera>(*_entities.begin());
+    auto& mainCamera = g_ECSManager.singleton<MainCamera>();
+    auto& transform  = mainCamera.transform;
+    auto& camera     = mainCamera.camera;
+
+    mainCamera.previousPosition = transform.position;
 
     bool isMoving = false;
-    isMoving     |= positionMovements(transform, camera, dt);
-    isMoving     |= lookAtMovements(camera);
+    if (_scripted)
+    {
+        updateFront(camera);
+        isMoving = true;
+    }
+    else
+    {
+        isMoving |= positionMovements(transform, camera, dt);
+        isMoving |= lookAtMovements(camera);
 
-    // Testings
-    transform.position.z = -0.275 + sin(glfwGetTime() / 2.5) * 2.15;
-    isMoving = true;
-    // End Testings
+        // Testings
+        _time += dt;
+        transform.position.z = -0.275 + sin(_time / 2.5) * 2.15;
+        isMoving = true;
+        // End Testings
+    }
 
-    if (isMoving || !_init)
+    // The renderer rebuilds its tile frustums when the projection changes
+    const float aspectRatio = g_Renderer.aspectRatio();
+    if (!_init || aspectRatio != _aspectRatio || camera.FOV != _FOV)
     {
-        camera.projection    = glm::perspective(glm::radians(camera.FOV), (float)g_Renderer.SCREEN_WIDTH / (float)g_Renderer.SCREEN_HEIGHT, 1.0f / 32.0f, 1024.0f);
+        camera.projection    = glm::perspective(glm::radians(camera.FOV), aspectRatio, 1.0f / 32.0f, 1024.0f);
         camera.invProjection = glm::inverse(camera.projection);
+        _aspectRatio = aspectRatio;
+        _FOV = camera.FOV;
+    }
+
+    if (isMoving || !_init)
+    {
         camera.view          = glm::lookAt(transform.position, transform.position + camera.front, camera.up);
         _init = true;
     }
@@ -83,7 +105,15 @@ bool CameraHandler::lookAtMovements(Camera& camera)
     const float sensitivity = 0.5f;
     camera.yaw  += g_InputManager.mouseOffset.x * sensitivity;
     camera.pitch = glm::clamp(camera.pitch - g_InputManager.mouseOffset.y * sensitivity, -89.99f, 89.99f);
+    updateFront(camera);
+
+    g_InputManager.resetMouseMovements();
+    return true;
+}
 
+// Direction of the camera from its yaw and pitch
+void CameraHandler::updateFront(Camera& camera) const
+{
     const glm::vec3 dir =
     {
         cos(glm::radians(camera.yaw)) * cos(glm::radians(camera.pitch)),
@@ -91,17 +121,19 @@ bool CameraHandler::lookAtMovements(Camera& camera)
         sin(glm::radians(camera.yaw)) * cos(glm::radians(camera.pitch))
     };
     camera.front = glm::normalize(dir);
+}
 
-    g_InputManager.resetMouseMovements();
-    return true;
+void CameraHandler::setScripted(const bool scripted)
+{
+    _scripted = scripted;
 }
 
 const Camera& CameraHandler::camera() const
 {
-    return g_ECSManager.getComponent<Camera>(*_entities.begin());
+    return std::as_const(g_ECSManager).singleton<MainCamera>().camera;
 }
 
 const Transform& CameraHandler::transform() const
 {
-    return g_ECSManager.getComponent<Transform>(*_entities.begin());
+    return std::as_const(g_ECSManager).singleton<MainCamera>().transform;
 }
\ No newline at end of file
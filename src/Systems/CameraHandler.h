@@ -1,20 +1,27 @@
 #pragma once
 
-#include "../Core/Subsystems/ECS/System.h"
-
 #include "../Components/Transform.h"
 #include "../Components/Camera.h"
 
 
-class CameraHandler : public System
+// Drives the MainCamera singleton, it is not an entity so this is not an ECS system
+class CameraHandler
 {
  public:
     void Update(const float dt);
     const Camera& camera() const;
     const Transform& transform() const;
 
+    // The camera is moved by its owner rather than by the inputs
+    void setScripted(const bool scripted);
+
  private:
     bool positionMovements(Transform& transform, const Camera& camera, const float dt);
     bool lookAtMovements(Camera& camera);
+    void updateFront(Camera& camera) const;
     bool _init = false;
+    bool _scripted = false;
+    float _time = 0.0f;    // Simulated, so replays move the same
+    float _aspectRatio = 0.0f;
+    float _FOV = 0.0f;
 };
@@ -0,0 +1,15 @@
+#include "InterpolationHandler.h"
+
+#include "../Core/Subsystems/ECS/ECSManager.h"
+
+extern ECSManager   g_ECSManager;
+
+void InterpolationHandler::Update()
+{
+    g_ECSManager.view<PreviousTransform, const Transform>().par_each([](PreviousTransform& previous, ConstTransformRef transform)
+    {
+        previous.position = transform.position;
+        previous.rotation = transform.rotation;
+        previous.scale    = transform.scale;
+    });
+}
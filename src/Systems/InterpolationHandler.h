@@ -0,0 +1,14 @@
+#pragma once
+
+#include "../Core/Subsystems/ECS/System.h"
+
+#include "../Components/Transform.h"
+#include "../Components/PreviousTransform.h"
+
+
+class InterpolationHandler : public System
+{
+ public:
+    // Keep the transforms of the step about to be simulated
+    void Update();
+};
@@ -1,28 +1,91 @@
 #include "PointLightsHandler.h"
 
 #include "../Core/Subsystems/ECS/ECSManager.h"
+#include "../Core/Subsystems/Jobs/ThreadPool.h"
 #include "../Core/Subsystems/Renderer/Renderer.h"
 
+#include <algorithm>
+#include <utility>
+
 extern ECSManager   g_ECSManager;
 extern Renderer     g_Renderer;
 
+// Field-wise over the packed transform positions, the run of a chunk is contiguous
 void PointLightsHandler::Update(const float dt)
 {
-    for (const auto& entity : _entities)
+    if (!_animated)
+    {
+        return;
+    }
+
+    gatherLights();
+
+    ComponentArray<Transform>& transforms = g_ECSManager.getComponentArray<Transform>();
+    auto chunkJob = [&](uint64_t chunk)
+    {
+        const LightRun& run = _runs[chunk];
+        const std::span<glm::vec3> positions = transforms.field<0>(run.transform, run.count);
+        const float* speeds = _speeds.data() + run.light;
+        for (uint32_t i = 0; i < run.count; ++i)
+        {
+            const float y = positions[i].y + speeds[i] * dt;
+            positions[i].y = y > 25 ? -5 : y;
+        }
+    };
+    ThreadPool::shared().parallelFor(_runs.size(), chunkJob);
+}
+
+// Speeds and runs of the lights, sorted by dense index of their transform
+void PointLightsHandler::gatherLights()
+{
+    const ComponentArray<PointLight>& lights = std::as_const(g_ECSManager).getComponentArray<PointLight>();
+    const ComponentArray<Transform>& transforms = std::as_const(g_ECSManager).getComponentArray<Transform>();
+
+    const std::array<uint64_t, 2> structureVersions = { lights.structureVersion(), transforms.structureVersion() };
+    if (structureVersions == _structureVersions)
+    {
+        return;
+    }
+    _structureVersions = structureVersions;
+
+    // Dense indices of the transform and the light of each lit entity
+    std::vector<std::pair<uint32_t, uint32_t>> rows;
+    rows.reserve(lights.size());
+    const std::span<const Entity> entities = lights.entities();
+    for (uint32_t i = 0; i < entities.size(); ++i)
+    {
+        const uint32_t transform = transforms.find(entities[i]);
+        if (transform != ComponentArray<Transform>::INVALID_INDEX)
+        {
+            rows.emplace_back(transform, i);
+        }
+    }
+    std::sort(rows.begin(), rows.end());
+
+    _speeds.resize(rows.size());
+    _runs.clear();
+    const std::span<const PointLight> components = lights.components();
+    for (uint32_t i = 0; i < rows.size(); ++i)
     {
-        auto& transform = g_ECSManager.getComponent<Transform>(entity);
-        auto& light     = g_ECSManager.getComponent<PointLight>(entity);
+        _speeds[i] = components[rows[i].second].color.r / 3.0f;
 
-        transform.position.y += (light.color.r / 3.0) * dt;
-        if (transform.position.y > 25)
+        if (!_runs.empty() && _runs.back().transform + _runs.back().count == rows[i].first && _runs.back().count < MAX_RUN_LENGTH)
         {
-            transform.position.y = -5;
+            ++_runs.back().count;
+        }
+        else
+        {
+            _runs.push_back({rows[i].first, i, 1});
         }
     }
-    
 }
 
 std::set<Entity>& PointLightsHandler::pointLights()
 {
     return _entities;
-}
\ No newline at end of file
+}
+
+void PointLightsHandler::setAnimated(const bool animated)
+{
+    _animated = animated;
+}
@@ -5,10 +5,37 @@
 #include "../Components/Transform.h"
 #include "../Components/PointLight.h"
 
+#include <array>
+#include <vector>
+
 
 class PointLightsHandler : public System
 {
  public:
     void Update(const float dt);
     std::set<Entity>& pointLights();
+
+    // Static lights keep their transforms, so they are not sent to the renderer again
+    void setAnimated(const bool animated);
+
+ private:
+    void gatherLights();
+
+    // Lights at consecutive dense indices of the transforms
+    struct LightRun
+    {
+        uint32_t    transform;  // Dense index of the first transform
+        uint32_t    light;      // Index of the first speed
+        uint32_t    count;
+    };
+
+    static constexpr uint32_t MAX_RUN_LENGTH = 4096; // Lights per chunk of the parallel loop
+
+    bool _animated = true;
+
+    // Rising speed of each light in the order of the transforms, read from its
+    // color when the lights or transforms are added or removed
+    std::vector<float>      _speeds;
+    std::vector<LightRun>   _runs;
+    std::array<uint64_t, 2> _structureVersions {};
 };
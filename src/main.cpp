@@ -1,7 +1,7 @@
 #include "Core/Core.h"
 
-int main()
+int main(int argc, char** argv)
 {
     Core core;
-    return core.Run();
+    return core.Run(argc, argv);
 }